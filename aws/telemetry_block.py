@@ -0,0 +1,124 @@
+"""
+Decoder for the firmware's delta/varint telemetry blocks (src/telemetry_block.h).
+
+A block holds consecutive windows column by column. Each column is fixed
+point (value * 10^decimals), stored as zigzag varints of the delta from
+the previous window; the time columns are delta-of-delta. Columns carry
+their byte length, so ids this decoder does not know are skipped.
+"""
+
+import base64
+
+BLOCK_MAGIC = b'VB'
+BLOCK_VERSION = 1
+
+# Column id -> window field name (ids are wire format, append only)
+COLUMN_FIELDS = {
+    0: 'timestamp_ms',
+    1: 'rms_g',
+    2: 'peak_g',
+    3: 'gx_rms',
+    4: 'gy_rms',
+    5: 'gz_rms',
+    6: 'gx_peak',
+    7: 'gy_peak',
+    8: 'gz_peak',
+    9: 'imu_temp_c',
+    10: 'start_us',
+    11: 'samples',
+    12: 'fault',
+    13: 'fault_conf',
+}
+DELTA_OF_DELTA_COLUMNS = {0, 10}
+
+# Fields the device leaves out of the JSON payload when they read 0
+OMIT_ZERO = {'imu_temp_c', 'start_us', 'fault_conf'}
+
+# Fault class id -> name (src/fault_classifier.h FaultClass, append only)
+FAULT_CLASSES = ['normal', 'imbalance', 'looseness', 'bearing']
+
+
+class BlockError(ValueError):
+    pass
+
+
+def _read_varint(data, pos, end):
+    value = 0
+    shift = 0
+    while True:
+        if pos >= end:
+            raise BlockError('truncated varint')
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if b < 0x80:
+            return value, pos
+        shift += 7
+        if shift > 63:
+            raise BlockError('varint too long')
+
+
+def _unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def decode_block(data):
+    """Decode a binary block into a list of window dicts, oldest first"""
+    data = bytes(data)
+    if len(data) < 4 or data[:2] != BLOCK_MAGIC:
+        raise BlockError('not a telemetry block')
+    if data[2] != BLOCK_VERSION:
+        raise BlockError(f'unsupported block version {data[2]}')
+
+    column_count = data[3]
+    count, pos = _read_varint(data, 4, len(data))
+    windows = [{} for _ in range(count)]
+
+    for _ in range(column_count):
+        if pos + 2 > len(data):
+            raise BlockError('truncated column header')
+        column_id, decimals = data[pos], data[pos + 1]
+        length, pos = _read_varint(data, pos + 2, len(data))
+        end = pos + length
+        if end > len(data):
+            raise BlockError('truncated column')
+
+        field = COLUMN_FIELDS.get(column_id)
+        if field is None:
+            pos = end
+            continue
+
+        value = 0
+        delta = 0
+        for window in windows:
+            raw, pos = _read_varint(data, pos, end)
+            if column_id in DELTA_OF_DELTA_COLUMNS:
+                delta += _unzigzag(raw)
+            else:
+                delta = _unzigzag(raw)
+            value += delta
+            window[field] = value if decimals == 0 else round(value / 10 ** decimals, decimals)
+        if pos != end:
+            raise BlockError(f'column {column_id} length mismatch')
+
+    for window in windows:
+        for field in OMIT_ZERO:
+            if window.get(field) == 0:
+                del window[field]
+        if 'timestamp_ms' in window:
+            window['timestamp'] = window['timestamp_ms'] // 1000
+
+        # The class only means something once the window was classified
+        fault = window.pop('fault', None)
+        if 'fault_conf' in window and fault is not None:
+            window['fault'] = FAULT_CLASSES[fault] if 0 <= fault < len(FAULT_CLASSES) else str(fault)
+
+    return windows
+
+
+def decode_message_windows(message):
+    """Windows of a block payload {"encoding": "vb1", "block": "<base64>"}"""
+    encoding = message.get('encoding')
+    if encoding != f'vb{BLOCK_VERSION}':
+        raise BlockError(f'unsupported encoding {encoding}')
+    return decode_block(base64.b64decode(message['block']))
@@ -0,0 +1,137 @@
+"""
+Offline throughput benchmark for timestream_writer.
+
+Feeds device payloads (JSON lines) through the writer with a local
+stand-in for the Timestream client, which validates every WriteRecords
+request against the API limits and counts records, calls and bytes.
+Pair it with the firmware's own payload formatter via the fleet
+simulator:
+
+    ../extras/fleet_sim/fleet_sim --emit-payloads 10000 --batch 12 \\
+        | python timestream_bench.py --group 10
+
+No AWS credentials or boto3 needed.
+"""
+
+import argparse
+import json
+import sys
+import time
+
+import telemetry_block
+import timestream_writer
+
+
+class FakeTimestreamClient:
+    """Validates and counts WriteRecords calls instead of sending them"""
+
+    VALID_TYPES = {'DOUBLE', 'BIGINT', 'VARCHAR', 'BOOLEAN', 'TIMESTAMP'}
+
+    def __init__(self, call_latency_ms=0.0):
+        self.call_latency = call_latency_ms / 1000.0
+        self.calls = 0
+        self.records = 0
+        self.request_bytes = 0
+
+    def write_records(self, DatabaseName, TableName, Records, CommonAttributes=None):
+        common = CommonAttributes or {}
+        if not 1 <= len(Records) <= timestream_writer.MAX_RECORDS_PER_WRITE:
+            raise ValueError(f"WriteRecords with {len(Records)} records")
+
+        seen = set()
+        for record in Records:
+            merged = dict(common, **record)
+            # Timestream merges record dimensions with the common ones
+            merged['Dimensions'] = common.get('Dimensions', []) + record.get('Dimensions', [])
+            for field in ('Time', 'TimeUnit', 'MeasureName', 'Dimensions'):
+                if field not in merged:
+                    raise ValueError(f"Record missing {field}: {record}")
+            if merged.get('MeasureValueType') == 'MULTI':
+                for value in merged['MeasureValues']:
+                    if value['Type'] not in self.VALID_TYPES:
+                        raise ValueError(f"Bad measure type {value}")
+                    if value['Type'] != 'VARCHAR':
+                        float(value['Value'])
+            int(merged['Time'])
+
+            # Same dimensions + time + measure name in one call is a conflict
+            key = (json.dumps(merged['Dimensions'], sort_keys=True), merged['Time'], merged['MeasureName'])
+            if key in seen:
+                raise ValueError(f"Duplicate record in request: {key}")
+            seen.add(key)
+
+        self.calls += 1
+        self.records += len(Records)
+        self.request_bytes += len(json.dumps({'CommonAttributes': common, 'Records': Records}))
+        if self.call_latency:
+            time.sleep(self.call_latency)
+        return {'RecordsIngested': {'Total': len(Records)}}
+
+
+def message_windows(message):
+    """Windows of a batched or block payload, None for a single-window payload"""
+    if 'block' in message:
+        return telemetry_block.decode_message_windows(message)
+    return message.get('windows')
+
+
+def legacy_record_count(message):
+    """Single-measure records the previous writer produced for a message"""
+    windows = message_windows(message)
+    if windows is None:
+        vibration = message.get('vibration', {})
+        health = message.get('health', {})
+        return (sum(1 for k in ('rms_g', 'peak_g') if vibration.get(k) is not None) +
+                sum(1 for k in ('battery_v', 'temp_c', 'imu_temp_c', 'rssi_dbm', 'uptime_sec', 'free_heap')
+                    if health.get(k) is not None))
+    # One single-window message per window
+    return sum(legacy_record_count({'vibration': w, 'health': message.get('health', {})}) for w in windows)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Offline timestream_writer benchmark')
+    parser.add_argument('files', nargs='*', help='JSON-lines payload files (default: stdin)')
+    parser.add_argument('--group', type=int, default=1,
+                        help='messages per Lambda invocation (IoT Rule batching / SQS)')
+    parser.add_argument('--call-latency-ms', type=float, default=0.0,
+                        help='simulated WriteRecords round-trip time')
+    args = parser.parse_args()
+
+    messages = []
+    sources = [open(f) for f in args.files] if args.files else [sys.stdin]
+    for source in sources:
+        messages.extend(json.loads(line) for line in source if line.strip())
+
+    if not messages:
+        print("No payloads read")
+        return 1
+
+    client = FakeTimestreamClient(args.call_latency_ms)
+    timestream_writer.set_client(client)
+
+    windows = sum(len(message_windows(m) or [None]) for m in messages)
+    payload_bytes = sum(len(json.dumps(m, separators=(',', ':'))) for m in messages)
+
+    start = time.perf_counter()
+    for i in range(0, len(messages), args.group):
+        timestream_writer.lambda_handler(messages[i:i + args.group], None)
+    elapsed = time.perf_counter() - start
+
+    legacy_records = sum(legacy_record_count(m) for m in messages)
+
+    print(f"\n=== timestream_writer ({len(messages)} messages, {windows} windows, "
+          f"{payload_bytes / len(messages):.0f} B/message) ===")
+    print(f"Throughput        : {len(messages) / elapsed:,.0f} messages/s, {windows / elapsed:,.0f} windows/s")
+    print(f"Records           : {client.records} ({client.records / len(messages):.2f}/message, "
+          f"{client.records / windows:.2f}/window)")
+    print(f"WriteRecords calls: {client.calls} ({client.calls / len(messages):.3f}/message, "
+          f"{client.records / client.calls:.1f} records/call)")
+    print(f"Request bytes     : {client.request_bytes / windows:.0f}/window")
+    print(f"Previous writer   : {legacy_records} single-measure records, {len(messages)} calls "
+          f"({legacy_records / max(client.records, 1):.1f}x records, "
+          f"{len(messages) / client.calls:.1f}x calls)")
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
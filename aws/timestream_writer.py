@@ -1,86 +1,229 @@
 import json
-import boto3
 import os
 from datetime import datetime
 
-timestream = boto3.client('timestream-write', region_name='us-east-1')
+import telemetry_block
+
+DATABASE_NAME = os.environ.get('TIMESTREAM_DATABASE', 'VibrationDB')
+TABLE_NAME = os.environ.get('TIMESTREAM_TABLE', 'Telemetry')
+
+# Multi-measure record name; query with WHERE measure_name = 'telemetry'
+MEASURE_NAME = 'telemetry'
+
+# Timestream WriteRecords accepts at most 100 records per call
+MAX_RECORDS_PER_WRITE = 100
+
+# (payload field, Timestream type)
+VIBRATION_MEASURES = [
+    ('rms_g', 'DOUBLE'),
+    ('peak_g', 'DOUBLE'),
+    ('start_us', 'BIGINT'),
+    ('samples', 'BIGINT'),
+    ('fault', 'VARCHAR'),
+    ('fault_conf', 'DOUBLE'),
+    ('gx_rms', 'DOUBLE'),
+    ('gy_rms', 'DOUBLE'),
+    ('gz_rms', 'DOUBLE'),
+    ('gx_peak', 'DOUBLE'),
+    ('gy_peak', 'DOUBLE'),
+    ('gz_peak', 'DOUBLE'),
+    ('imu_temp_c', 'DOUBLE'),
+]
+HEALTH_MEASURES = [
+    ('battery_v', 'DOUBLE'),
+    ('temp_c', 'DOUBLE'),
+    ('imu_temp_c', 'DOUBLE'),
+    ('rssi_dbm', 'BIGINT'),
+    ('uptime_sec', 'BIGINT'),
+    ('free_heap', 'BIGINT'),
+]
+
+_timestream = None
+
+
+def get_client():
+    """Create the Timestream client on first use (boto3 is only needed in Lambda)"""
+    global _timestream
+    if _timestream is None:
+        import boto3
+        _timestream = boto3.client('timestream-write', region_name='us-east-1')
+    return _timestream
+
+
+def set_client(client):
+    """Swap in another client, e.g. the offline stand-in in timestream_bench.py"""
+    global _timestream
+    _timestream = client
+
+
+def _window_time_ms(window, fallback_ms):
+    """Window time in milliseconds: timestamp_ms, else timestamp (seconds)"""
+    if window.get('timestamp_ms') is not None:
+        return int(window['timestamp_ms'])
+    if window.get('timestamp') is not None:
+        return int(window['timestamp']) * 1000
+    return fallback_ms
+
+
+def _measure_values(*sources):
+    """Collect non-null measures from (dict, [(name, type)]) pairs, first wins"""
+    values = []
+    seen = set()
+    for data, measures in sources:
+        for name, value_type in measures:
+            if name in seen or data.get(name) is None:
+                continue
+            seen.add(name)
+            values.append({'Name': name, 'Value': str(data[name]), 'Type': value_type})
+    return values
+
+
+def _record(time_ms, values, sensor=None):
+    """One multi-measure record; windows of a named sensor get a sensor dimension"""
+    record = {'Time': str(time_ms), 'MeasureValues': values}
+    if sensor is not None:
+        record['Dimensions'] = [{'Name': 'sensor', 'Value': str(sensor)}]
+    return record
+
+
+def records_from_message(message):
+    """
+    Convert one device message into multi-measure records.
+
+    Accepts the single-window payload
+        {"device_id", "timestamp"[, "timestamp_ms"], "vibration": {...}, "health": {...}}
+    the batched payload
+        {"device_id", "health": {...}, "windows": [{"timestamp_ms", "rms_g", "peak_g"}, ...]}
+    and the same windows as a delta/varint block (telemetry_block.py)
+        {"device_id", "health": {...}, "encoding": "vb1", "block": "<base64>"}
+
+    Multi-sensor devices add "sensor" (the sensor of the top-level
+    window(s)) and, on single-window payloads, "sensors": {name: {...}}
+    with each other sensor's latest window. Those records carry a
+    sensor dimension.
+
+    Returns a list of (device_id, record) tuples; each record carries
+    all measures of one window at one timestamp.
+    """
+    device_id = str(message.get('device_id'))
+    now_ms = int(datetime.now().timestamp() * 1000)
+    health = message.get('health', {})
+    records = []
+
+    windows = message.get('windows')
+    if windows is None and 'block' in message:
+        windows = telemetry_block.decode_message_windows(message)
+    if windows is None:
+        # Single window: vibration and health share the window's timestamp
+        windows = [dict(message.get('vibration', {}),
+                        timestamp=message.get('timestamp'),
+                        timestamp_ms=message.get('timestamp_ms'))]
+
+    # Health is sampled at publish time, so it belongs to the newest window
+    newest = max(range(len(windows)), key=lambda i: _window_time_ms(windows[i], now_ms), default=None)
+
+    for i, window in enumerate(windows):
+        sources = [(window, VIBRATION_MEASURES)]
+        if i == newest:
+            sources.append((health, HEALTH_MEASURES))
+
+        values = _measure_values(*sources)
+        if not values:
+            continue
+
+        records.append((device_id, _record(_window_time_ms(window, now_ms), values, message.get('sensor'))))
+
+    # Other sensors' windows carry their own close time
+    for name, window in message.get('sensors', {}).items():
+        values = _measure_values((window, VIBRATION_MEASURES))
+        if values:
+            records.append((device_id, _record(_window_time_ms(window, now_ms), values, name)))
+
+    return records
+
+
+def build_write_requests(device_records):
+    """
+    Coalesce (device_id, record) tuples into WriteRecords requests of at
+    most MAX_RECORDS_PER_WRITE records. Attributes shared by every record
+    in a request are hoisted into CommonAttributes; the device_id
+    dimension is hoisted too when a request holds a single device.
+    Record dimensions (sensor) stay on the record either way.
+    """
+    requests = []
+
+    for start in range(0, len(device_records), MAX_RECORDS_PER_WRITE):
+        chunk = device_records[start:start + MAX_RECORDS_PER_WRITE]
+        common = {
+            'MeasureName': MEASURE_NAME,
+            'MeasureValueType': 'MULTI',
+            'TimeUnit': 'MILLISECONDS',
+        }
+
+        devices = {device_id for device_id, _ in chunk}
+        if len(devices) == 1:
+            common['Dimensions'] = [{'Name': 'device_id', 'Value': chunk[0][0]}]
+            records = [record for _, record in chunk]
+        else:
+            records = [dict(record, Dimensions=[{'Name': 'device_id', 'Value': device_id}]
+                            + record.get('Dimensions', []))
+                       for device_id, record in chunk]
+
+        requests.append({
+            'DatabaseName': DATABASE_NAME,
+            'TableName': TABLE_NAME,
+            'CommonAttributes': common,
+            'Records': records,
+        })
+
+    return requests
+
+
+def _messages_from_event(event):
+    """An IoT Rule delivers one message; batching rules and tests may pass a list"""
+    if isinstance(event, list):
+        return event
+    if 'messages' in event:
+        return event['messages']
+    return [event]
+
+
+def write_messages(messages):
+    """Write device messages to Timestream; returns (records, write calls)"""
+    device_records = []
+    for message in messages:
+        device_records.extend(records_from_message(message))
+
+    # Group by device so most requests can hoist the dimension
+    device_records.sort(key=lambda item: item[0])
+
+    requests = build_write_requests(device_records)
+    client = get_client()
+    for request in requests:
+        try:
+            client.write_records(**request)
+        except Exception as e:
+            # QoS 1 retransmits are identical records and are accepted;
+            # anything rejected here is a real schema/time problem
+            rejected = getattr(e, 'response', {}).get('RejectedRecords')
+            if rejected:
+                print(f"Rejected records: {rejected}")
+            raise
+
+    return len(device_records), len(requests)
 
-DATABASE_NAME = 'VibrationDB'
-TABLE_NAME = 'Telemetry'
 
 def lambda_handler(event, context):
     """Write IoT telemetry to Timestream"""
-    
+
     try:
-        # Extract data from MQTT payload
-        device_id = event.get('device_id')
-        timestamp = event.get('timestamp', int(datetime.now().timestamp()))
-        vibration = event.get('vibration', {})
-        health = event.get('health', {})
-        
-        # Prepare dimensions (indexed columns)
-        dimensions = [
-            {'Name': 'device_id', 'Value': str(device_id)}
-        ]
-        
-        # Prepare measures (time-series values)
-        records = []
-        
-        # Vibration measures
-        if vibration.get('rms_g') is not None:
-            records.append({
-                'MeasureName': 'rms_g',
-                'MeasureValue': str(vibration['rms_g']),
-                'MeasureValueType': 'DOUBLE',
-                'Time': str(timestamp),
-                'TimeUnit': 'SECONDS',
-                'Dimensions': dimensions
-            })
-        
-        if vibration.get('peak_g') is not None:
-            records.append({
-                'MeasureName': 'peak_g',
-                'MeasureValue': str(vibration['peak_g']),
-                'MeasureValueType': 'DOUBLE',
-                'Time': str(timestamp),
-                'TimeUnit': 'SECONDS',
-                'Dimensions': dimensions
-            })
-        
-        # Health measures
-        for measure_name in ['battery_v', 'temp_c', 'imu_temp_c']:
-            if health.get(measure_name) is not None:
-                records.append({
-                    'MeasureName': measure_name,
-                    'MeasureValue': str(health[measure_name]),
-                    'MeasureValueType': 'DOUBLE',
-                    'Time': str(timestamp),
-                    'TimeUnit': 'SECONDS',
-                    'Dimensions': dimensions
-                })
-        
-        for measure_name in ['rssi_dbm', 'uptime_sec', 'free_heap']:
-            if health.get(measure_name) is not None:
-                records.append({
-                    'MeasureName': measure_name,
-                    'MeasureValue': str(health[measure_name]),
-                    'MeasureValueType': 'BIGINT',
-                    'Time': str(timestamp),
-                    'TimeUnit': 'SECONDS',
-                    'Dimensions': dimensions
-                })
-        
-        # Write to Timestream
+        records, calls = write_messages(_messages_from_event(event))
+
         if records:
-            result = timestream.write_records(
-                DatabaseName=DATABASE_NAME,
-                TableName=TABLE_NAME,
-                Records=records
-            )
-            print(f"Successfully wrote {len(records)} records to Timestream")
+            print(f"Successfully wrote {records} records in {calls} WriteRecords calls")
             return {
                 'statusCode': 200,
-                'body': json.dumps(f'Wrote {len(records)} records')
+                'body': json.dumps(f'Wrote {records} records')
             }
         else:
             print("No valid records to write")
@@ -88,8 +231,7 @@ def lambda_handler(event, context):
                 'statusCode': 400,
                 'body': json.dumps('No valid records')
             }
-            
+
     except Exception as e:
         print(f"Error: {str(e)}")
         raise
-
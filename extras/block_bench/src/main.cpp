@@ -0,0 +1,298 @@
+// Telemetry block benchmark
+//
+// Reads recorded device payloads (JSON lines: the firmware's single-window
+// or batched format, e.g. from mosquitto_sub or fleet_sim --emit-payloads),
+// regroups each device's windows into uploads of --batch windows and
+// compares the batched JSON payload with the delta/varint block payload.
+// Both are built with the firmware's own code (telemetry_format.cpp,
+// telemetry_block.cpp).
+//
+// Reports bytes per window, compression ratio and encode time per window.
+// --emit prints the block payloads instead, for decoding on the ingest side
+// (aws/timestream_bench.py).
+
+#include "config.h"
+#include "fault_classifier.h"
+#include "telemetry_block.h"
+#include "telemetry_format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+struct Options {
+    int batch = TELEMETRY_BLOCK_MAX;   // Windows per upload
+    int repeat = 20;                   // Encode passes for timing
+    bool emit = false;                 // Print block payloads
+};
+
+static Options opts;
+
+static int64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// Just enough JSON to pull numbers out of the firmware's flat payloads
+
+static bool findNumber(const char* begin, const char* end, const char* key, double& out) {
+    char quoted[32];
+    snprintf(quoted, sizeof(quoted), "\"%s\":", key);
+    size_t keyLen = strlen(quoted);
+
+    for (const char* p = begin; p + keyLen <= end; p++) {
+        if (memcmp(p, quoted, keyLen) == 0) {
+            out = strtod(p + keyLen, nullptr);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool findString(const char* line, const char* key, std::string& out) {
+    char quoted[32];
+    snprintf(quoted, sizeof(quoted), "\"%s\":\"", key);
+    const char* p = strstr(line, quoted);
+    if (p == nullptr) {
+        return false;
+    }
+    p += strlen(quoted);
+    const char* q = strchr(p, '"');
+    if (q == nullptr) {
+        return false;
+    }
+    out.assign(p, q);
+    return true;
+}
+
+// Fault class id from its telemetry name, searched within one window
+static bool findFault(const char* begin, const char* end, uint8_t& out) {
+    static const char KEY[] = "\"fault\":\"";
+    size_t keyLen = strlen(KEY);
+
+    for (const char* p = begin; p + keyLen <= end; p++) {
+        if (memcmp(p, KEY, keyLen) != 0) {
+            continue;
+        }
+        p += keyLen;
+        for (uint8_t c = 0; c < FAULT_CLASS_COUNT; c++) {
+            size_t nameLen = strlen(faultClassName(c));
+            if (p + nameLen < end && memcmp(p, faultClassName(c), nameLen) == 0 && p[nameLen] == '"') {
+                out = c;
+                return true;
+            }
+        }
+        return false;
+    }
+    return false;
+}
+
+static void parseWindow(const char* begin, const char* end, VibrationMetrics& m) {
+    static const char* GYRO_RMS[3] = {"gx_rms", "gy_rms", "gz_rms"};
+    static const char* GYRO_PEAK[3] = {"gx_peak", "gy_peak", "gz_peak"};
+    double v;
+
+    m = VibrationMetrics();
+    if (findNumber(begin, end, "timestamp_ms", v)) {
+        m.epoch_ms = (uint64_t)v;
+    } else if (findNumber(begin, end, "timestamp", v)) {
+        m.epoch_ms = (uint64_t)v * 1000;
+    }
+    if (findNumber(begin, end, "rms_g", v)) m.rms_g = (float)v;
+    if (findNumber(begin, end, "peak_g", v)) m.peak_g = (float)v;
+    if (findNumber(begin, end, "start_us", v)) m.start_epoch_us = (uint64_t)v;
+    if (findNumber(begin, end, "samples", v)) m.sample_count = (uint16_t)v;
+    if (findNumber(begin, end, "imu_temp_c", v)) m.temp_c = (float)v;
+    if (findNumber(begin, end, "fault_conf", v) && findFault(begin, end, m.fault_class)) {
+        m.fault_confidence = (uint8_t)lround(v * 100.0);
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        if (findNumber(begin, end, GYRO_RMS[axis], v)) m.gyro_rms_dps[axis] = (float)v;
+        if (findNumber(begin, end, GYRO_PEAK[axis], v)) m.gyro_peak_dps[axis] = (float)v;
+    }
+    m.valid = true;
+}
+
+// Append every window in one payload line to its device's series
+static void parseLine(const char* line, std::map<std::string, std::vector<VibrationMetrics>>& series) {
+    std::string deviceId;
+    if (!findString(line, "device_id", deviceId)) {
+        return;
+    }
+    std::vector<VibrationMetrics>& out = series[deviceId];
+    const char* lineEnd = line + strlen(line);
+
+    const char* windows = strstr(line, "\"windows\":[");
+    if (windows == nullptr) {
+        // Single window: time at top level, metrics under "vibration"
+        VibrationMetrics m;
+        parseWindow(line, lineEnd, m);
+        if (m.epoch_ms != 0) {
+            out.push_back(m);
+        }
+        return;
+    }
+
+    // Batched: flat objects, no nesting inside a window
+    for (const char* p = strchr(windows, '{'); p != nullptr; p = strchr(p, '{')) {
+        const char* close = strchr(p, '}');
+        if (close == nullptr) {
+            break;
+        }
+        VibrationMetrics m;
+        parseWindow(p, close, m);
+        if (m.epoch_ms != 0) {
+            out.push_back(m);
+        }
+        p = close;
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+static void usage() {
+    fprintf(stderr,
+            "Usage: block_bench [--batch N] [--repeat N] [--emit] [payloads.jsonl ...]\n"
+            "Reads stdin when no file is given\n");
+    exit(2);
+}
+
+static void parseArgs(int argc, char** argv, std::vector<const char*>& files) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        if (!strcmp(a, "--emit")) {
+            opts.emit = true;
+            continue;
+        }
+        if (a[0] != '-') {
+            files.push_back(a);
+            continue;
+        }
+        if (i + 1 >= argc) usage();
+        const char* v = argv[++i];
+        if (!strcmp(a, "--batch")) opts.batch = atoi(v);
+        else if (!strcmp(a, "--repeat")) opts.repeat = atoi(v);
+        else usage();
+    }
+
+    if (opts.batch < 1 || opts.repeat < 1) {
+        usage();
+    }
+}
+
+static void readFile(FILE* f, std::map<std::string, std::vector<VibrationMetrics>>& series) {
+    std::string line;
+    int c;
+    while ((c = fgetc(f)) != EOF) {
+        if (c != '\n') {
+            line.push_back((char)c);
+            continue;
+        }
+        parseLine(line.c_str(), series);
+        line.clear();
+    }
+    if (!line.empty()) {
+        parseLine(line.c_str(), series);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> files;
+    parseArgs(argc, argv, files);
+
+    std::map<std::string, std::vector<VibrationMetrics>> series;
+    if (files.empty()) {
+        readFile(stdin, series);
+    }
+    for (const char* path : files) {
+        FILE* f = fopen(path, "r");
+        if (f == nullptr) {
+            perror(path);
+            return 1;
+        }
+        readFile(f, series);
+        fclose(f);
+    }
+
+    // Health is per upload and identical in both formats
+    const TelemetryHealth health = {4.1f, 35.0f, -60, 3600, 180000};
+    std::vector<char> payload((size_t)opts.batch * 256 + 512);
+    std::vector<uint8_t> block((size_t)opts.batch * 64 + 64);
+
+    size_t windows = 0, uploads = 0;
+    size_t jsonBytes = 0, blockBytes = 0, blockPayloadBytes = 0;
+    int64_t jsonNs = 0, blockNs = 0, blockPayloadNs = 0;
+
+    for (auto& entry : series) {
+        std::vector<VibrationMetrics>& w = entry.second;
+        std::stable_sort(w.begin(), w.end(), [](const VibrationMetrics& a, const VibrationMetrics& b) {
+            return a.epoch_ms < b.epoch_ms;
+        });
+        const char* id = entry.first.c_str();
+
+        for (size_t start = 0; start < w.size(); start += opts.batch) {
+            size_t n = std::min((size_t)opts.batch, w.size() - start);
+            const VibrationMetrics* chunk = &w[start];
+
+            size_t jsonLen = 0, blockLen = 0, payloadLen = 0;
+            int64_t t0 = nowNs();
+            for (int r = 0; r < opts.repeat; r++) {
+                jsonLen = telemetryFormatBatchPayload(payload.data(), payload.size(), chunk, n, health, id);
+            }
+            int64_t t1 = nowNs();
+            for (int r = 0; r < opts.repeat; r++) {
+                blockLen = telemetryEncodeBlock(block.data(), block.size(), chunk, n);
+            }
+            int64_t t2 = nowNs();
+            for (int r = 0; r < opts.repeat; r++) {
+                payloadLen = telemetryFormatBlockPayload(payload.data(), payload.size(), chunk, n, health, id);
+            }
+            int64_t t3 = nowNs();
+
+            if (jsonLen == 0 || blockLen == 0 || payloadLen == 0) {
+                fprintf(stderr, "Encode failed for %s at window %zu\n", id, start);
+                return 1;
+            }
+            if (opts.emit) {
+                puts(payload.data());
+            }
+
+            windows += n;
+            uploads++;
+            jsonBytes += jsonLen;
+            blockBytes += blockLen;
+            blockPayloadBytes += payloadLen;
+            jsonNs += t1 - t0;
+            blockNs += t2 - t1;
+            blockPayloadNs += t3 - t2;
+        }
+    }
+
+    if (opts.emit) {
+        return 0;
+    }
+    if (windows == 0) {
+        fprintf(stderr, "No timestamped windows in input\n");
+        return 1;
+    }
+
+    double perWindow = (double)opts.repeat * windows;
+    printf("=== Telemetry blocks (%zu devices, %zu windows, %zu uploads of up to %d) ===\n",
+           series.size(), windows, uploads, opts.batch);
+    printf("Batched JSON      : %6.1f B/window  %7.1f ns/window\n",
+           (double)jsonBytes / windows, jsonNs / perWindow);
+    printf("Block (binary)    : %6.1f B/window  %7.1f ns/window  %5.1fx smaller\n",
+           (double)blockBytes / windows, blockNs / perWindow, (double)jsonBytes / blockBytes);
+    printf("Block payload     : %6.1f B/window  %7.1f ns/window  %5.1fx smaller (base64 in JSON, with health)\n",
+           (double)blockPayloadBytes / windows, blockPayloadNs / perWindow, (double)jsonBytes / blockPayloadBytes);
+    return 0;
+}
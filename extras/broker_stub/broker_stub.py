@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+"""
+Minimal MQTT 3.1.1 broker stand-in for reliability testing.
+
+Accepts plain-TCP connections from the firmware (build with
+MQTT_TEST_BROKER_HOST set in secrets.h) and can deliberately lose
+traffic so QoS 1 retransmission can be exercised on a desk:
+
+  --drop-puback P   swallow the PUBACK for a received QoS 1 publish
+  --drop-publish P  pretend a publish never arrived (no ack, not counted)
+  --kill P          close the connection after a packet (forces reconnect)
+
+Every received publish is logged; duplicates are detected by payload so
+the summary shows how many unique messages made it through.
+
+Publishes to AWS IoT Basic Ingest topics ($aws/rules/<rule>/<topic>) are
+checked the way AWS IoT routes them: --rule names the rules that exist,
+the message goes to that rule only (never to subscribers), and the rule
+sees <topic> without the prefix. A malformed topic or unknown rule gets
+no PUBACK, so the device's retransmit counters show the misconfiguration.
+
+Usage:
+    python broker_stub.py --port 1883 --drop-puback 0.2 --kill 0.05
+    python broker_stub.py --rule VibrationToTimestream
+"""
+
+import argparse
+import asyncio
+import hashlib
+import json
+import random
+import re
+import signal
+import time
+
+# MQTT control packet types
+CONNECT, CONNACK, PUBLISH, PUBACK = 1, 2, 3, 4
+SUBSCRIBE, SUBACK, PINGREQ, PINGRESP, DISCONNECT = 8, 9, 12, 13, 14
+
+INGEST_PREFIX = '$aws/rules/'
+RULE_NAME = re.compile(r'^[A-Za-z0-9_]{1,128}$')
+
+
+class Stats:
+    def __init__(self):
+        self.connections = 0
+        self.publishes = 0
+        self.duplicates = 0
+        self.dropped_publish = 0
+        self.dropped_puback = 0
+        self.killed = 0
+        self.ingested = {}          # rule -> messages delivered to it
+        self.ingest_rejected = 0
+        self.missing_device_id = 0
+        self.seen = set()
+        self.started = time.time()
+
+    def summary(self):
+        elapsed = time.time() - self.started
+        text = (f"{self.connections} connections, {self.publishes} publishes "
+                f"({len(self.seen)} unique, {self.duplicates} duplicates), "
+                f"dropped {self.dropped_publish} publishes / {self.dropped_puback} PUBACKs, "
+                f"killed {self.killed} connections in {elapsed:.0f}s")
+        if self.ingested or self.ingest_rejected:
+            rules = ', '.join(f"{rule} {count}" for rule, count in sorted(self.ingested.items()))
+            text += (f"; basic ingest: {rules or 'none'}, {self.ingest_rejected} rejected, "
+                     f"{self.missing_device_id} without device_id")
+        return text
+
+
+async def read_packet(reader):
+    """Read one MQTT packet; returns (type, flags, body)."""
+    header = await reader.readexactly(1)
+    length, multiplier = 0, 1
+    while True:
+        b = (await reader.readexactly(1))[0]
+        length += (b & 0x7F) * multiplier
+        multiplier *= 128
+        if not b & 0x80:
+            break
+    body = await reader.readexactly(length) if length else b''
+    return header[0] >> 4, header[0] & 0x0F, body
+
+
+def parse_publish(flags, body):
+    qos = (flags >> 1) & 0x03
+    topic_len = int.from_bytes(body[0:2], 'big')
+    topic = body[2:2 + topic_len].decode('utf-8', 'replace')
+    pos = 2 + topic_len
+    packet_id = None
+    if qos > 0:
+        packet_id = int.from_bytes(body[pos:pos + 2], 'big')
+        pos += 2
+    return topic, qos, packet_id, bool(flags & 0x08), body[pos:]
+
+
+class Broker:
+    def __init__(self, args):
+        self.args = args
+        self.stats = Stats()
+        self.rng = random.Random(args.seed)
+
+    def chance(self, p):
+        return p > 0 and self.rng.random() < p
+
+    def on_publish(self, topic, payload, qos, dup):
+        """Hook for received messages; returns a short log suffix."""
+        return ''
+
+    def ingest(self, topic, payload):
+        """Route a Basic Ingest publish; returns (accepted, log suffix)."""
+        rule, _, rule_topic = topic[len(INGEST_PREFIX):].partition('/')
+        if not RULE_NAME.match(rule) or not rule_topic:
+            self.stats.ingest_rejected += 1
+            return False, ' REJECTED: expected $aws/rules/<rule>/<topic>'
+        if self.args.rule and rule not in self.args.rule:
+            self.stats.ingest_rejected += 1
+            return False, f' REJECTED: no rule {rule}'
+
+        # Without the broker topic the rule can only take the device from
+        # the payload (or topic(n) of the topic after the prefix)
+        try:
+            device_id = json.loads(payload).get('device_id')
+        except (ValueError, AttributeError):
+            device_id = None
+        if device_id is None:
+            self.stats.missing_device_id += 1
+        self.stats.ingested[rule] = self.stats.ingested.get(rule, 0) + 1
+        return True, f" -> rule {rule} topic {rule_topic} device_id={device_id or 'MISSING'}"
+
+    async def handle(self, reader, writer):
+        peer = writer.get_extra_info('peername')
+        self.stats.connections += 1
+        client_id = '?'
+
+        try:
+            while True:
+                ptype, flags, body = await read_packet(reader)
+
+                if ptype == CONNECT:
+                    # Protocol name, level, flags, keep-alive, then client id
+                    name_len = int.from_bytes(body[0:2], 'big')
+                    pos = 2 + name_len + 4
+                    id_len = int.from_bytes(body[pos:pos + 2], 'big')
+                    client_id = body[pos + 2:pos + 2 + id_len].decode('utf-8', 'replace')
+                    print(f"[{peer[0]}] CONNECT client_id={client_id}")
+                    writer.write(bytes([CONNACK << 4, 2, 0, 0]))
+
+                elif ptype == PUBLISH:
+                    topic, qos, packet_id, dup, payload = parse_publish(flags, body)
+
+                    if self.chance(self.args.drop_publish):
+                        self.stats.dropped_publish += 1
+                        print(f"[{client_id}] DROP publish id={packet_id} {topic}")
+                        continue
+
+                    self.stats.publishes += 1
+                    digest = hashlib.sha1(topic.encode() + payload).digest()
+                    duplicate = digest in self.stats.seen
+                    if duplicate:
+                        self.stats.duplicates += 1
+                    self.stats.seen.add(digest)
+
+                    accepted = True
+                    if topic.startswith(INGEST_PREFIX):
+                        accepted, extra = self.ingest(topic, payload)
+                    else:
+                        extra = self.on_publish(topic, payload, qos, dup)
+                    print(f"[{client_id}] PUBLISH qos={qos} id={packet_id} dup={int(dup)} "
+                          f"{topic} ({len(payload)} bytes){' DUPLICATE' if duplicate else ''}{extra}")
+
+                    if qos == 1 and accepted:
+                        if self.chance(self.args.drop_puback):
+                            self.stats.dropped_puback += 1
+                            print(f"[{client_id}] DROP puback id={packet_id}")
+                        else:
+                            writer.write(bytes([PUBACK << 4, 2]) + packet_id.to_bytes(2, 'big'))
+
+                elif ptype == SUBSCRIBE:
+                    packet_id = body[0:2]
+                    writer.write(bytes([SUBACK << 4, 3]) + packet_id + bytes([0]))
+
+                elif ptype == PINGREQ:
+                    writer.write(bytes([PINGRESP << 4, 0]))
+
+                elif ptype == DISCONNECT:
+                    break
+
+                await writer.drain()
+
+                if self.chance(self.args.kill):
+                    self.stats.killed += 1
+                    print(f"[{client_id}] KILL connection")
+                    break
+
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            writer.close()
+            print(f"[{client_id}] closed. {self.stats.summary()}")
+
+
+async def main(broker):
+    server = await asyncio.start_server(broker.handle, broker.args.host, broker.args.port)
+    print(f"Broker stub listening on {broker.args.host}:{broker.args.port}")
+
+    stop = asyncio.Event()
+    loop = asyncio.get_running_loop()
+    for sig in (signal.SIGINT, signal.SIGTERM):
+        try:
+            loop.add_signal_handler(sig, stop.set)
+        except NotImplementedError:
+            pass  # Windows: Ctrl+C raises KeyboardInterrupt instead
+
+    async with server:
+        await stop.wait()
+
+    print(f"Summary: {broker.stats.summary()}")
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Lossy MQTT 3.1.1 broker stand-in')
+    parser.add_argument('--host', default='0.0.0.0')
+    parser.add_argument('--port', type=int, default=1883)
+    parser.add_argument('--drop-puback', type=float, default=0.0, help='probability to swallow a PUBACK')
+    parser.add_argument('--drop-publish', type=float, default=0.0, help='probability to ignore a publish')
+    parser.add_argument('--kill', type=float, default=0.0, help='probability to close the connection after a packet')
+    parser.add_argument('--rule', action='append', default=[],
+                        help='IoT rule accepting Basic Ingest publishes (repeatable; none = any name)')
+    parser.add_argument('--seed', type=int, default=None)
+    return parser.parse_args()
+
+
+if __name__ == '__main__':
+    try:
+        asyncio.run(main(Broker(parse_args())))
+    except KeyboardInterrupt:
+        pass
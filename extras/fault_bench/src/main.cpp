@@ -0,0 +1,475 @@
+// Fault classifier benchmark and trainer
+//
+// Synthesizes labelled windows of the four machine states the firmware
+// classifies (normal, imbalance, looseness, bearing defect), runs them
+// through the firmware's own feature path (SlidingStats, spectrum.cpp,
+// fault_classifier.cpp) and reports, for the model compiled into
+// fault_model.h:
+//   - accuracy and confusion matrix on a held-out set
+//   - inference and feature-extraction time per window
+//   - model bytes in flash
+//
+// --export trains a new tree ensemble on the same features and writes it
+// as fault_model.h; rebuild (firmware and bench) to use it.
+
+#include "config.h"
+#include "fault_classifier.h"
+#include "fault_model.h"
+#include "sliding_stats.h"
+#include "spectrum.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+struct Options {
+    int train = 800;         // Training windows per class
+    int test = 400;          // Held-out windows per class
+    int trees = 8;
+    int depth = 6;
+    int minLeaf = 5;
+    int repeat = 200;        // Inference passes over the test set, for timing
+    uint64_t seed = 1;
+    const char* exportPath = nullptr;
+};
+
+static Options opts;
+
+static const int WINDOW = IMU_WINDOW_SAMPLES;
+static const float RATE_HZ = IMU_SAMPLE_RATE_HZ;
+
+static int64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// Deterministic random numbers (xorshift64*)
+
+struct Rng {
+    uint64_t state;
+
+    explicit Rng(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+
+    float uniform(float lo = 0.0f, float hi = 1.0f) {
+        return lo + (hi - lo) * (float)((next() >> 40) / 16777216.0);
+    }
+
+    int below(int n) {
+        return (int)(next() % (uint64_t)n);
+    }
+
+    float gaussian() {
+        float u = uniform(1e-7f, 1.0f);
+        float v = uniform();
+        return sqrtf(-2.0f * logf(u)) * cosf(2.0f * (float)M_PI * v);
+    }
+
+    void unitVector(float out[3]) {
+        float len;
+        do {
+            for (int i = 0; i < 3; i++) out[i] = gaussian();
+            len = sqrtf(out[0] * out[0] + out[1] * out[1] + out[2] * out[2]);
+        } while (len < 1e-3f);
+        for (int i = 0; i < 3; i++) out[i] /= len;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Synthetic machine signatures, as the sensor sees them: gravity in an
+// arbitrary mounting direction plus vibration along a direction with a
+// component along gravity (so it shows in |accel|), plus sensor noise
+
+static void synthesize(FaultClass cls, Rng& rng, float xyz[][3]) {
+    float g[3], dir[3];
+    rng.unitVector(g);
+    do {
+        rng.unitVector(dir);
+    } while (fabsf(dir[0] * g[0] + dir[1] * g[1] + dir[2] * g[2]) < 0.5f);
+
+    float runHz = rng.uniform(10.0f, 45.0f);   // 600..2700 rpm
+    float noise = rng.uniform(0.003f, 0.012f);
+    float amp[7] = {};
+    float phase[7];
+    for (int k = 0; k < 7; k++) {
+        phase[k] = rng.uniform(0.0f, 2.0f * (float)M_PI);
+    }
+
+    // Bearing defect: resonance rung at the outer-race defect rate
+    float defectHz = 0.0f, resonanceHz = 0.0f, decayS = 1.0f, impulseG = 0.0f, firstS = 0.0f;
+
+    switch (cls) {
+        case FAULT_NORMAL:
+            amp[1] = rng.uniform(0.0f, 0.015f);
+            amp[2] = amp[1] * rng.uniform(0.0f, 0.3f);
+            break;
+        case FAULT_IMBALANCE:
+            amp[1] = rng.uniform(0.03f, 0.4f);
+            amp[2] = amp[1] * rng.uniform(0.0f, 0.15f);
+            amp[3] = amp[1] * rng.uniform(0.0f, 0.05f);
+            break;
+        case FAULT_LOOSENESS:
+            amp[1] = rng.uniform(0.02f, 0.25f);
+            for (int k = 2; k <= 6; k++) {
+                amp[k] = amp[1] * rng.uniform(0.3f, 1.0f) * powf(0.8f, (float)(k - 2));
+            }
+            break;
+        case FAULT_BEARING:
+            amp[1] = rng.uniform(0.002f, 0.04f);
+            defectHz = runHz * rng.uniform(3.0f, 5.5f);
+            resonanceHz = rng.uniform(140.0f, 230.0f);
+            decayS = rng.uniform(0.002f, 0.006f);
+            impulseG = rng.uniform(0.08f, 0.8f);
+            firstS = rng.uniform(0.0f, 1.0f / defectHz);
+            break;
+        default:
+            break;
+    }
+
+    for (int i = 0; i < WINDOW; i++) {
+        float t = i / RATE_HZ;
+        float s = 0.0f;
+        for (int k = 1; k < 7; k++) {
+            if (amp[k] > 0.0f) {
+                s += amp[k] * sinf(2.0f * (float)M_PI * k * runHz * t + phase[k]);
+            }
+        }
+        if (impulseG > 0.0f && t >= firstS) {
+            // Only the latest few impulses are still ringing
+            int latest = (int)((t - firstS) * defectHz);
+            for (int j = latest; j >= 0 && j > latest - 3; j--) {
+                float dt = t - (firstS + j / defectHz);
+                s += impulseG * expf(-dt / decayS) * sinf(2.0f * (float)M_PI * resonanceHz * dt);
+            }
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            xyz[i][axis] = g[axis] + dir[axis] * s + noise * rng.gaussian();
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Firmware feature path
+
+struct Sample {
+    FaultFeatures features;
+    uint8_t label;
+};
+
+static SlidingStats<IMU_WINDOW_SAMPLES> magStats;
+
+static void extract(const float xyz[][3], FaultFeatures& features) {
+    magStats.reset(WINDOW);
+    for (int i = 0; i < WINDOW; i++) {
+        magStats.push(sqrtf(xyz[i][0] * xyz[i][0] + xyz[i][1] * xyz[i][1] + xyz[i][2] * xyz[i][2]));
+    }
+
+    VibrationSpectrum spectrum = {};
+    spectrumCompute(xyz, WINDOW, 0, RATE_HZ, spectrum);
+    faultExtractFeatures(spectrum, magStats.acRms(), magStats.acPeak(), features);
+}
+
+static std::vector<Sample> makeSet(int perClass, uint64_t seed) {
+    Rng rng(seed);
+    static float xyz[IMU_WINDOW_SAMPLES][3];
+    std::vector<Sample> set;
+    for (int i = 0; i < perClass; i++) {
+        for (int c = 0; c < FAULT_CLASS_COUNT; c++) {
+            Sample s;
+            synthesize((FaultClass)c, rng, xyz);
+            extract(xyz, s.features);
+            s.label = (uint8_t)c;
+            set.push_back(s);
+        }
+    }
+    return set;
+}
+
+// ---------------------------------------------------------------------------
+// Tree ensemble training (bagged CART, Gini, random feature subsets)
+
+struct Model {
+    std::vector<uint16_t> roots;
+    std::vector<FaultNode> nodes;
+    std::vector<std::array<uint8_t, FAULT_CLASS_COUNT>> leaves;
+    int depth = 0;
+};
+
+static uint16_t makeLeaf(Model& model, const std::vector<const Sample*>& samples) {
+    int counts[FAULT_CLASS_COUNT] = {};
+    for (const Sample* s : samples) counts[s->label]++;
+
+    std::array<uint8_t, FAULT_CLASS_COUNT> leaf;
+    for (int c = 0; c < FAULT_CLASS_COUNT; c++) {
+        leaf[c] = (uint8_t)lroundf(255.0f * counts[c] / samples.size());
+    }
+    model.leaves.push_back(leaf);
+    return (uint16_t)((model.leaves.size() - 1) | FAULT_NODE_LEAF);
+}
+
+static double gini(const int* counts, int n) {
+    if (n == 0) return 0.0;
+    double g = 1.0;
+    for (int c = 0; c < FAULT_CLASS_COUNT; c++) {
+        double p = (double)counts[c] / n;
+        g -= p * p;
+    }
+    return g;
+}
+
+static uint16_t buildTree(Model& model, std::vector<const Sample*>& samples, int depth, Rng& rng) {
+    int counts[FAULT_CLASS_COUNT] = {};
+    for (const Sample* s : samples) counts[s->label]++;
+    bool pure = std::count(counts, counts + FAULT_CLASS_COUNT, (int)samples.size()) == 1;
+
+    if (depth >= opts.depth || pure || (int)samples.size() < 2 * opts.minLeaf) {
+        return makeLeaf(model, samples);
+    }
+
+    // Random subset of about sqrt(features) candidates per split
+    int order[FAULT_FEATURE_COUNT];
+    for (int f = 0; f < FAULT_FEATURE_COUNT; f++) order[f] = f;
+    for (int f = FAULT_FEATURE_COUNT - 1; f > 0; f--) std::swap(order[f], order[rng.below(f + 1)]);
+    int tries = (int)ceilf(sqrtf((float)FAULT_FEATURE_COUNT));
+
+    double bestScore = gini(counts, (int)samples.size());
+    int bestFeature = -1;
+    int16_t bestThreshold = 0;
+    for (int t = 0; t < tries; t++) {
+        int f = order[t];
+        std::sort(samples.begin(), samples.end(),
+                  [f](const Sample* a, const Sample* b) { return a->features.v[f] < b->features.v[f]; });
+
+        int left[FAULT_CLASS_COUNT] = {};
+        int right[FAULT_CLASS_COUNT];
+        memcpy(right, counts, sizeof(right));
+        int n = (int)samples.size();
+        for (int i = 0; i < n - 1; i++) {
+            left[samples[i]->label]++;
+            right[samples[i]->label]--;
+            int16_t a = samples[i]->features.v[f];
+            int16_t b = samples[i + 1]->features.v[f];
+            if (a == b || i + 1 < opts.minLeaf || n - i - 1 < opts.minLeaf) {
+                continue;
+            }
+            double score = ((i + 1) * gini(left, i + 1) + (n - i - 1) * gini(right, n - i - 1)) / n;
+            if (score < bestScore - 1e-12) {
+                bestScore = score;
+                bestFeature = f;
+                bestThreshold = (int16_t)(a + (b - a) / 2);
+            }
+        }
+    }
+
+    if (bestFeature < 0) {
+        return makeLeaf(model, samples);
+    }
+
+    std::vector<const Sample*> lo, hi;
+    for (const Sample* s : samples) {
+        (s->features.v[bestFeature] > bestThreshold ? hi : lo).push_back(s);
+    }
+
+    size_t index = model.nodes.size();
+    model.nodes.push_back(FaultNode{(uint8_t)bestFeature, bestThreshold, {0, 0}});
+    model.depth = std::max(model.depth, depth + 1);
+    uint16_t l = buildTree(model, lo, depth + 1, rng);
+    uint16_t r = buildTree(model, hi, depth + 1, rng);
+    model.nodes[index].child[0] = l;
+    model.nodes[index].child[1] = r;
+    return (uint16_t)index;
+}
+
+static Model train(const std::vector<Sample>& set) {
+    Model model;
+    Rng rng(opts.seed ^ 0x5EED);
+    for (int t = 0; t < opts.trees; t++) {
+        // Bootstrap sample
+        std::vector<const Sample*> bag;
+        for (size_t i = 0; i < set.size(); i++) {
+            bag.push_back(&set[rng.below((int)set.size())]);
+        }
+        model.roots.push_back(buildTree(model, bag, 0, rng));
+    }
+    return model;
+}
+
+static uint8_t predict(const Model& model, const FaultFeatures& features) {
+    uint32_t votes[FAULT_CLASS_COUNT] = {};
+    for (uint16_t index : model.roots) {
+        while (!(index & FAULT_NODE_LEAF)) {
+            const FaultNode& node = model.nodes[index];
+            index = node.child[features.v[node.feature] > node.threshold];
+        }
+        for (int c = 0; c < FAULT_CLASS_COUNT; c++) votes[c] += model.leaves[index & ~FAULT_NODE_LEAF][c];
+    }
+    return (uint8_t)(std::max_element(votes, votes + FAULT_CLASS_COUNT) - votes);
+}
+
+static bool exportModel(const Model& model, const char* path) {
+    FILE* f = fopen(path, "w");
+    if (f == nullptr) {
+        return false;
+    }
+
+    fprintf(f, "#ifndef FAULT_MODEL_H\n#define FAULT_MODEL_H\n\n");
+    fprintf(f, "// Generated by extras/fault_bench --export (seed %llu, %d windows per class,\n",
+            (unsigned long long)opts.seed, opts.train);
+    fprintf(f, "// synthetic signatures); do not edit. Included by fault_classifier.cpp and the bench.\n\n");
+    fprintf(f, "#include \"fault_classifier.h\"\n\n");
+    fprintf(f, "#define FAULT_MODEL_TREES  %d\n", (int)model.roots.size());
+    fprintf(f, "#define FAULT_MODEL_DEPTH  %d     // Longest root-to-leaf path\n\n", model.depth);
+
+    fprintf(f, "static const uint16_t FAULT_MODEL_ROOTS[FAULT_MODEL_TREES] = {");
+    for (size_t i = 0; i < model.roots.size(); i++) {
+        fprintf(f, "%s0x%04x", i == 0 ? "" : ", ", model.roots[i]);
+    }
+    fprintf(f, "};\n\n");
+
+    fprintf(f, "static const FaultNode FAULT_MODEL_NODES[] = {\n");
+    for (const FaultNode& n : model.nodes) {
+        fprintf(f, "    {%u, %d, {0x%04x, 0x%04x}},\n", n.feature, n.threshold, n.child[0], n.child[1]);
+    }
+    fprintf(f, "};\n\n");
+
+    fprintf(f, "static const uint8_t FAULT_MODEL_LEAVES[][FAULT_CLASS_COUNT] = {\n");
+    for (const auto& leaf : model.leaves) {
+        fprintf(f, "    {");
+        for (int c = 0; c < FAULT_CLASS_COUNT; c++) {
+            fprintf(f, "%s%u", c == 0 ? "" : ", ", leaf[c]);
+        }
+        fprintf(f, "},\n");
+    }
+    fprintf(f, "};\n\n#endif // FAULT_MODEL_H\n");
+
+    fclose(f);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+
+static void printConfusion(const int confusion[FAULT_CLASS_COUNT][FAULT_CLASS_COUNT]) {
+    printf("%-12s", "true \\ pred");
+    for (int c = 0; c < FAULT_CLASS_COUNT; c++) printf("%11s", faultClassName(c));
+    printf("\n");
+    for (int t = 0; t < FAULT_CLASS_COUNT; t++) {
+        printf("%-12s", faultClassName(t));
+        for (int p = 0; p < FAULT_CLASS_COUNT; p++) printf("%11d", confusion[t][p]);
+        printf("\n");
+    }
+}
+
+static void usage() {
+    fprintf(stderr,
+            "Usage: fault_bench [--train N] [--test N] [--seed S] [--repeat N]\n"
+            "                   [--export fault_model.h [--trees N] [--depth N] [--min-leaf N]]\n");
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value != nullptr && strcmp(arg, "--train") == 0) { opts.train = atoi(value); i++; }
+        else if (value != nullptr && strcmp(arg, "--test") == 0) { opts.test = atoi(value); i++; }
+        else if (value != nullptr && strcmp(arg, "--trees") == 0) { opts.trees = atoi(value); i++; }
+        else if (value != nullptr && strcmp(arg, "--depth") == 0) { opts.depth = atoi(value); i++; }
+        else if (value != nullptr && strcmp(arg, "--min-leaf") == 0) { opts.minLeaf = atoi(value); i++; }
+        else if (value != nullptr && strcmp(arg, "--repeat") == 0) { opts.repeat = atoi(value); i++; }
+        else if (value != nullptr && strcmp(arg, "--seed") == 0) { opts.seed = strtoull(value, nullptr, 10); i++; }
+        else if (value != nullptr && strcmp(arg, "--export") == 0) { opts.exportPath = value; i++; }
+        else { usage(); return 1; }
+    }
+
+    // Held-out windows never share a seed with the training set
+    std::vector<Sample> test = makeSet(opts.test, opts.seed + 1000);
+
+    if (opts.exportPath != nullptr) {
+        std::vector<Sample> trainSet = makeSet(opts.train, opts.seed);
+        Model model = train(trainSet);
+
+        int correct = 0;
+        for (const Sample& s : test) correct += predict(model, s.features) == s.label;
+        size_t bytes = model.nodes.size() * sizeof(FaultNode) + model.leaves.size() * FAULT_CLASS_COUNT +
+                       model.roots.size() * sizeof(uint16_t);
+        printf("Trained %d trees (depth %d, %zu nodes, %zu leaves, %zu B): %.1f%% held-out accuracy\n",
+               (int)model.roots.size(), model.depth, model.nodes.size(), model.leaves.size(), bytes,
+               100.0 * correct / test.size());
+
+        if (!exportModel(model, opts.exportPath)) {
+            fprintf(stderr, "Cannot write %s\n", opts.exportPath);
+            return 1;
+        }
+        printf("Wrote %s; rebuild to benchmark it\n", opts.exportPath);
+        return 0;
+    }
+
+    // Compiled-in model: accuracy
+    int confusion[FAULT_CLASS_COUNT][FAULT_CLASS_COUNT] = {};
+    int correct = 0;
+    uint64_t confidenceSum = 0;
+    for (const Sample& s : test) {
+        FaultResult result;
+        faultClassify(s.features, result);
+        confusion[s.label][result.label]++;
+        correct += result.label == s.label;
+        confidenceSum += result.confidence;
+    }
+
+    // Inference time
+    volatile uint32_t sink = 0;
+    int64_t start = nowNs();
+    for (int r = 0; r < opts.repeat; r++) {
+        for (const Sample& s : test) {
+            FaultResult result;
+            faultClassify(s.features, result);
+            sink += result.label;
+        }
+    }
+    double classifyNs = (double)(nowNs() - start) / ((double)opts.repeat * test.size());
+
+    // Feature extraction time (from a finished spectrum, as on the device)
+    static float xyz[IMU_WINDOW_SAMPLES][3];
+    Rng rng(opts.seed + 2000);
+    synthesize(FAULT_BEARING, rng, xyz);
+    VibrationSpectrum spectrum = {};
+    int64_t spectrumStart = nowNs();
+    for (int r = 0; r < opts.repeat; r++) {
+        spectrumCompute(xyz, WINDOW, 0, RATE_HZ, spectrum);
+    }
+    double spectrumNs = (double)(nowNs() - spectrumStart) / opts.repeat;
+    FaultFeatures features;
+    int64_t featureStart = nowNs();
+    for (int r = 0; r < opts.repeat * 100; r++) {
+        faultExtractFeatures(spectrum, 0.05f + r * 1e-6f, 0.2f, features);
+        sink += features.v[0];
+    }
+    double featureNs = (double)(nowNs() - featureStart) / (opts.repeat * 100.0);
+
+    printf("=== Fault classifier (%d trees, depth %d, %zu held-out windows) ===\n",
+           FAULT_MODEL_TREES, FAULT_MODEL_DEPTH, test.size());
+    printf("Accuracy          : %.1f%% (mean confidence %.0f%%)\n",
+           100.0 * correct / test.size(), (double)confidenceSum / test.size());
+    printf("Model (flash)     : %zu B (limit FAULT_MODEL_MAX_BYTES %d)\n", faultModelBytes(), FAULT_MODEL_MAX_BYTES);
+    printf("Inference         : %8.1f ns/window (at most %d comparisons)\n",
+           classifyNs, FAULT_MODEL_TREES * FAULT_MODEL_DEPTH);
+    printf("Features          : %8.1f ns/window\n", featureNs);
+    printf("Spectrum (context): %8.1f ns/window\n\n", spectrumNs);
+    printConfusion(confusion);
+
+    return 0;
+}
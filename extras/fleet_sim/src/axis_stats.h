@@ -0,0 +1,58 @@
+#ifndef AXIS_STATS_H
+#define AXIS_STATS_H
+
+// Simulator only: tumbling windows need no sample buffer, unlike the
+// firmware's sliding ones (src/sliding_stats.h)
+
+#include <math.h>
+#include <stdint.h>
+
+// Streaming statistics for one axis over a window: O(1) work per sample
+// and no sample buffer. RMS and peak are taken about the window mean, so
+// a constant offset (gyro bias, slow rotation) does not count as vibration.
+struct AxisStats {
+    float sum;
+    float sumSq;
+    float min;
+    float max;
+    uint32_t count;
+
+    void reset() {
+        sum = 0.0f;
+        sumSq = 0.0f;
+        min = INFINITY;
+        max = -INFINITY;
+        count = 0;
+    }
+
+    void add(float v) {
+        sum += v;
+        sumSq += v * v;
+        if (v < min) min = v;
+        if (v > max) max = v;
+        count++;
+    }
+
+    float mean() const {
+        return count > 0 ? sum / count : 0.0f;
+    }
+
+    float rms() const {
+        if (count == 0) {
+            return 0.0f;
+        }
+        float m = mean();
+        float var = sumSq / count - m * m;
+        return var > 0.0f ? sqrtf(var) : 0.0f;
+    }
+
+    float peak() const {
+        if (count == 0) {
+            return 0.0f;
+        }
+        float m = mean();
+        return fmaxf(max - m, m - min);
+    }
+};
+
+#endif // AXIS_STATS_H
@@ -0,0 +1,711 @@
+// Simulated-fleet load generator
+//
+// Spins up thousands of virtual Core2 devices on Linux, each with its own
+// device ID, telemetry topic and QoS 1 in-flight window, and drives an
+// MQTT broker with the same payloads the firmware publishes. The payload
+// formatter, topic scheme and PUBACK tracking are the firmware's own
+// (telemetry_format.cpp, mqtt_inflight.cpp); only the IMU and the MQTT
+// socket layer are simulated here.
+//
+// Reports publish throughput, PUBACK latency percentiles and CPU cost
+// per message for broker/ingest capacity planning.
+
+#include "axis_stats.h"
+#include "config.h"
+#include "mqtt_inflight.h"
+#include "telemetry_format.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+struct Options {
+    const char* host = "127.0.0.1";
+    int port = 1883;
+    int devices = 1000;
+    int threads = 4;
+    int intervalMs = TELEMETRY_INTERVAL_MS;
+    int durationS = 60;
+    int qos = MQTT_TELEMETRY_QOS;
+    int windowSamples = IMU_WINDOW_SAMPLES;
+    const char* idPrefix = "SIM";
+    const char* ingestRule = nullptr;   // Publish via Basic Ingest to this rule
+    int emitPayloads = 0;   // >0: print payloads instead of connecting
+    int batch = 1;          // Windows per emitted payload
+};
+
+static Options opts;
+static std::atomic<bool> running(true);
+
+static int64_t nowUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t epochMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Stamp a window closing at closeMs with its start and sample count, as a
+// synced device does
+static void stampWindow(VibrationMetrics& m, uint64_t closeMs) {
+    m.epoch_ms = closeMs;
+    m.start_epoch_us = closeMs * 1000 - (uint64_t)opts.windowSamples * 1000000 / IMU_SAMPLE_RATE_HZ;
+    m.sample_count = (uint16_t)opts.windowSamples;
+}
+
+// ---------------------------------------------------------------------------
+// Simulated IMU: gravity on Z plus a machine tone and noise on all axes,
+// and the same tone rocking the gyro about Z, reduced to RMS/peak exactly
+// like imu_sampler's computeMetrics()
+
+struct SimImu {
+    std::mt19937 rng;
+    float toneHz;
+    float amplitudeG;
+    float phase;
+
+    void init(uint32_t seed) {
+        rng.seed(seed);
+        std::uniform_real_distribution<float> hz(10.0f, 120.0f);
+        std::uniform_real_distribution<float> amp(0.02f, 1.5f);
+        toneHz = hz(rng);
+        amplitudeG = amp(rng);
+        phase = 0.0f;
+    }
+
+    void window(VibrationMetrics& m) {
+        std::normal_distribution<float> noise(0.0f, 0.02f);
+        const float dt = 1.0f / IMU_SAMPLE_RATE_HZ;
+        std::normal_distribution<float> gyroNoise(0.0f, 0.1f);
+        float sumSq = 0.0f;
+        float maxMag = 0.0f;
+        AxisStats gyro[3];
+        for (int axis = 0; axis < 3; axis++) {
+            gyro[axis].reset();
+        }
+
+        for (int i = 0; i < opts.windowSamples; i++) {
+            float v = amplitudeG * sinf(phase);
+            phase += 2.0f * (float)M_PI * toneHz * dt;
+            if (phase > 2.0f * (float)M_PI) {
+                phase -= 2.0f * (float)M_PI;
+            }
+
+            float x = v + noise(rng);
+            float y = 0.3f * v + noise(rng);
+            float z = 1.0f + noise(rng);
+            float mag = sqrtf(x*x + y*y + z*z);
+
+            sumSq += mag * mag;
+            if (mag > maxMag) {
+                maxMag = mag;
+            }
+
+            // deg/s with a small constant bias, as a real gyro reads
+            gyro[0].add(0.5f + gyroNoise(rng));
+            gyro[1].add(-0.3f + gyroNoise(rng));
+            gyro[2].add(4.0f * v + gyroNoise(rng));
+        }
+
+        int n = opts.windowSamples > 0 ? opts.windowSamples : 1;
+        m.rms_g = sqrtf(sumSq / n);
+        m.peak_g = maxMag;
+        for (int axis = 0; axis < 3; axis++) {
+            m.gyro_rms_dps[axis] = gyro[axis].rms();
+            m.gyro_peak_dps[axis] = gyro[axis].peak();
+        }
+        m.temp_c = 30.0f;
+        m.valid = true;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Minimal MQTT 3.1.1 encoding (the firmware uses ArduinoMqttClient)
+
+static void putLength(std::string& out, size_t len) {
+    do {
+        uint8_t b = len % 128;
+        len /= 128;
+        if (len > 0) {
+            b |= 0x80;
+        }
+        out.push_back((char)b);
+    } while (len > 0);
+}
+
+static void putString(std::string& out, const char* s, size_t len) {
+    out.push_back((char)(len >> 8));
+    out.push_back((char)(len & 0xFF));
+    out.append(s, len);
+}
+
+static void encodeConnect(std::string& out, const char* clientId) {
+    std::string body;
+    putString(body, "MQTT", 4);
+    body.push_back(4);      // Protocol level 3.1.1
+    body.push_back(0x02);   // Clean session
+    body.push_back(0);      // Keep-alive disabled for the benchmark
+    body.push_back(0);
+    putString(body, clientId, strlen(clientId));
+
+    out.push_back(0x10);
+    putLength(out, body.size());
+    out += body;
+}
+
+static void encodePublish(std::string& out, const char* topic, size_t topicLen,
+                          const char* payload, size_t len, int qos, uint16_t packetId) {
+    size_t remaining = 2 + topicLen + (qos > 0 ? 2 : 0) + len;
+    out.push_back((char)(0x30 | (qos << 1)));
+    putLength(out, remaining);
+    putString(out, topic, topicLen);
+    if (qos > 0) {
+        out.push_back((char)(packetId >> 8));
+        out.push_back((char)(packetId & 0xFF));
+    }
+    out.append(payload, len);
+}
+
+// ---------------------------------------------------------------------------
+// Virtual device
+
+enum DeviceState {
+    DEV_IDLE,
+    DEV_CONNECTING,     // TCP connect in progress
+    DEV_CONNACK_WAIT,   // CONNECT sent
+    DEV_RUNNING,
+    DEV_FAILED
+};
+
+struct Device {
+    int fd = -1;
+    DeviceState state = DEV_IDLE;
+    char id[24];
+    char topic[MQTT_INFLIGHT_TOPIC_MAX];
+    size_t topicLen = 0;
+    uint16_t nextPacketId = 1;
+    uint8_t connackSeen = 0;
+    uint32_t uptimeBase = 0;
+    std::string txPending;
+    MqttPacketScanner rx;
+    MqttInflightWindow inflight;
+    SimImu imu;
+};
+
+struct ThreadStats {
+    uint64_t published = 0;
+    uint64_t acked = 0;
+    uint64_t bytes = 0;
+    uint64_t windowFull = 0;
+    uint64_t errors = 0;
+    uint64_t formatNs = 0;
+    std::vector<uint32_t> ackLatencyUs;
+};
+
+struct Worker {
+    std::vector<Device> devices;
+    int firstIndex = 0;
+    int epfd = -1;
+    ThreadStats stats;
+    std::atomic<uint64_t> publishedLive{0};
+};
+
+static bool resolveBroker(struct sockaddr_in& addr) {
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(opts.port);
+    if (inet_pton(AF_INET, opts.host, &addr.sin_addr) == 1) {
+        return true;
+    }
+
+    struct addrinfo hints = {};
+    struct addrinfo* res = nullptr;
+    hints.ai_family = AF_INET;
+    if (getaddrinfo(opts.host, nullptr, &hints, &res) != 0 || res == nullptr) {
+        return false;
+    }
+    addr.sin_addr = ((struct sockaddr_in*)res->ai_addr)->sin_addr;
+    freeaddrinfo(res);
+    return true;
+}
+
+static void watch(Worker& w, int idx, bool wantWrite) {
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN | (wantWrite ? (uint32_t)EPOLLOUT : 0u);
+    ev.data.u32 = (uint32_t)idx;
+    epoll_ctl(w.epfd, EPOLL_CTL_MOD, w.devices[idx].fd, &ev);
+}
+
+static void fail(Worker& w, Device& d) {
+    if (d.fd >= 0) {
+        epoll_ctl(w.epfd, EPOLL_CTL_DEL, d.fd, nullptr);
+        close(d.fd);
+        d.fd = -1;
+    }
+    d.state = DEV_FAILED;
+    w.stats.errors++;
+}
+
+static void flushTx(Worker& w, int idx) {
+    Device& d = w.devices[idx];
+    while (!d.txPending.empty()) {
+        ssize_t n = send(d.fd, d.txPending.data(), d.txPending.size(), MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                watch(w, idx, true);
+                return;
+            }
+            fail(w, d);
+            return;
+        }
+        w.stats.bytes += n;
+        d.txPending.erase(0, n);
+    }
+    watch(w, idx, false);
+}
+
+static void startConnect(Worker& w, int idx, const struct sockaddr_in& addr) {
+    Device& d = w.devices[idx];
+
+    d.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (d.fd < 0) {
+        d.state = DEV_FAILED;
+        w.stats.errors++;
+        return;
+    }
+
+    int one = 1;
+    setsockopt(d.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.u32 = (uint32_t)idx;
+    epoll_ctl(w.epfd, EPOLL_CTL_ADD, d.fd, &ev);
+
+    if (connect(d.fd, (const struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        fail(w, d);
+        return;
+    }
+    d.state = DEV_CONNECTING;
+}
+
+static void publish(Worker& w, int idx) {
+    Device& d = w.devices[idx];
+    if (d.state != DEV_RUNNING) {
+        return;
+    }
+
+    VibrationMetrics m = {};
+    d.imu.window(m);
+    int64_t windowUs = nowUs();
+    stampWindow(m, epochMs() / 1000 * 1000);  // Windows end on UTC seconds
+    m.window_us = windowUs;
+
+    TelemetryHealth health;
+    health.battery_v = 4.1f;
+    health.temp_c = 35.0f;
+    health.rssi_dbm = -60;
+    health.uptime_sec = d.uptimeBase + (uint32_t)(windowUs / 1000000);
+    health.free_heap = 180000;
+
+    char payload[MQTT_INFLIGHT_PAYLOAD_MAX];
+    int64_t t0 = nowUs();
+    size_t len = telemetryFormatPayload(payload, sizeof(payload), m, health, d.id, (unsigned long)(m.epoch_ms / 1000));
+    w.stats.formatNs += (uint64_t)(nowUs() - t0) * 1000;
+    if (len == 0) {
+        w.stats.errors++;
+        return;
+    }
+
+    uint16_t packetId = 0;
+    if (opts.qos > 0) {
+        int slot = d.inflight.reserve(d.topic, payload, len, windowUs);
+        if (slot < 0) {
+            w.stats.windowFull++;
+            return;
+        }
+        packetId = d.nextPacketId++;
+        if (d.nextPacketId == 0) {
+            d.nextPacketId = 1;  // 0 is not a valid packet id
+        }
+        d.inflight.markSent(slot, packetId, nowUs());
+    }
+
+    encodePublish(d.txPending, d.topic, d.topicLen, payload, len, opts.qos, packetId);
+    w.stats.published++;
+    w.publishedLive.fetch_add(1, std::memory_order_relaxed);
+    flushTx(w, idx);
+}
+
+static void onReadable(Worker& w, int idx) {
+    Device& d = w.devices[idx];
+    uint8_t buf[2048];
+
+    while (d.fd >= 0) {
+        ssize_t n = recv(d.fd, buf, sizeof(buf), 0);
+        if (n == 0) {
+            fail(w, d);
+            return;
+        }
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                fail(w, d);
+            }
+            return;
+        }
+
+        for (ssize_t i = 0; i < n; i++) {
+            // CONNACK is the first 4 bytes on the connection
+            if (d.state == DEV_CONNACK_WAIT) {
+                if (d.connackSeen == 3 && buf[i] != 0) {
+                    fprintf(stderr, "%s: CONNACK refused (%u)\n", d.id, buf[i]);
+                    fail(w, d);
+                    return;
+                }
+                if (++d.connackSeen == 4) {
+                    d.state = DEV_RUNNING;
+                }
+                continue;
+            }
+
+            if (d.rx.feed(buf[i]) == MqttPacketScanner::EVENT_PUBACK) {
+                int slot = d.inflight.findAcked(d.rx.packetId());
+                if (slot >= 0) {
+                    w.stats.ackLatencyUs.push_back((uint32_t)(nowUs() - d.inflight.slot(slot).sentUs));
+                    d.inflight.release(slot);
+                    w.stats.acked++;
+                }
+            }
+        }
+    }
+}
+
+static void runWorker(Worker* worker, const struct sockaddr_in addr, int64_t startUs) {
+    Worker& w = *worker;
+    w.epfd = epoll_create1(0);
+
+    typedef std::pair<int64_t, int> Due;   // (time, device index)
+    std::priority_queue<Due, std::vector<Due>, std::greater<Due>> schedule;
+
+    // Spread connects over the first interval and publishes uniformly
+    // across the interval so the fleet does not publish in lockstep
+    const int64_t intervalUs = (int64_t)opts.intervalMs * 1000;
+    for (size_t i = 0; i < w.devices.size(); i++) {
+        int global = w.firstIndex + (int)i;
+        int64_t offset = intervalUs * global / opts.devices;
+        schedule.push(Due(startUs + offset, (int)i));
+    }
+
+    const int64_t endUs = startUs + (int64_t)opts.durationS * 1000000;
+    struct epoll_event events[256];
+
+    while (running.load(std::memory_order_relaxed)) {
+        int64_t now = nowUs();
+        if (now >= endUs) {
+            break;
+        }
+
+        // Fire everything that is due
+        while (!schedule.empty() && schedule.top().first <= now) {
+            Due due = schedule.top();
+            schedule.pop();
+            Device& d = w.devices[due.second];
+
+            if (d.state == DEV_IDLE) {
+                startConnect(w, due.second, addr);
+            } else {
+                publish(w, due.second);
+            }
+
+            if (d.state != DEV_FAILED) {
+                schedule.push(Due(due.first + intervalUs, due.second));
+            }
+        }
+
+        int timeoutMs = 100;
+        if (!schedule.empty()) {
+            int64_t waitUs = schedule.top().first - nowUs();
+            timeoutMs = waitUs <= 0 ? 0 : (int)std::min<int64_t>(100, (waitUs + 999) / 1000);
+        }
+
+        int n = epoll_wait(w.epfd, events, 256, timeoutMs);
+        for (int i = 0; i < n; i++) {
+            int idx = (int)events[i].data.u32;
+            Device& d = w.devices[idx];
+            if (d.fd < 0) {
+                continue;
+            }
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                fail(w, d);
+                continue;
+            }
+
+            if ((events[i].events & EPOLLOUT) && d.state == DEV_CONNECTING) {
+                int err = 0;
+                socklen_t errLen = sizeof(err);
+                getsockopt(d.fd, SOL_SOCKET, SO_ERROR, &err, &errLen);
+                if (err != 0) {
+                    fail(w, d);
+                    continue;
+                }
+                d.state = DEV_CONNACK_WAIT;
+                encodeConnect(d.txPending, d.id);
+            }
+
+            if (events[i].events & EPOLLOUT) {
+                flushTx(w, idx);
+            }
+            if (events[i].events & EPOLLIN) {
+                onReadable(w, idx);
+            }
+        }
+    }
+
+    for (Device& d : w.devices) {
+        if (d.fd >= 0) {
+            close(d.fd);
+        }
+    }
+    close(w.epfd);
+}
+
+// ---------------------------------------------------------------------------
+
+static void raiseFdLimit(int needed) {
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < (rlim_t)needed) {
+        lim.rlim_cur = std::min<rlim_t>(lim.rlim_max, (rlim_t)needed);
+        setrlimit(RLIMIT_NOFILE, &lim);
+        if (lim.rlim_cur < (rlim_t)needed) {
+            fprintf(stderr, "WARNING: fd limit %lu < %d devices (raise ulimit -n)\n",
+                    (unsigned long)lim.rlim_cur, needed);
+        }
+    }
+}
+
+static double cpuSeconds() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+           ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+}
+
+static uint32_t percentile(std::vector<uint32_t>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t idx = (size_t)std::ceil(p * sorted.size());
+    return sorted[idx == 0 ? 0 : std::min(idx - 1, sorted.size() - 1)];
+}
+
+static void usage() {
+    fprintf(stderr,
+            "Usage: fleet_sim [--host H] [--port P] [--devices N] [--threads T]\n"
+            "                 [--interval-ms MS] [--duration S] [--qos 0|1]\n"
+            "                 [--window-samples N] [--id-prefix STR] [--basic-ingest RULE]\n"
+            "       fleet_sim --emit-payloads N [--batch K] [--devices N]\n");
+    exit(2);
+}
+
+static void parseArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!strcmp(a, "--help") || !v) {
+            usage();
+        }
+
+        if (!strcmp(a, "--host")) opts.host = v;
+        else if (!strcmp(a, "--port")) opts.port = atoi(v);
+        else if (!strcmp(a, "--devices")) opts.devices = atoi(v);
+        else if (!strcmp(a, "--threads")) opts.threads = atoi(v);
+        else if (!strcmp(a, "--interval-ms")) opts.intervalMs = atoi(v);
+        else if (!strcmp(a, "--duration")) opts.durationS = atoi(v);
+        else if (!strcmp(a, "--qos")) opts.qos = atoi(v);
+        else if (!strcmp(a, "--window-samples")) opts.windowSamples = atoi(v);
+        else if (!strcmp(a, "--id-prefix")) opts.idPrefix = v;
+        else if (!strcmp(a, "--basic-ingest")) opts.ingestRule = v;
+        else if (!strcmp(a, "--emit-payloads")) opts.emitPayloads = atoi(v);
+        else if (!strcmp(a, "--batch")) opts.batch = atoi(v);
+        else usage();
+        i++;
+    }
+
+    if (opts.batch < 1 || opts.devices < 1 || opts.threads < 1 || opts.intervalMs < 1 || opts.qos < 0 || opts.qos > 1) {
+        usage();
+    }
+    opts.threads = std::min(opts.threads, opts.devices);
+}
+
+// Print payloads as JSON lines (one per message) for offline ingest
+// benchmarks such as aws/timestream_bench.py
+static int emitPayloads() {
+    std::vector<SimImu> imus(opts.devices);
+    for (int i = 0; i < opts.devices; i++) {
+        imus[i].init((uint32_t)(i + 1));
+    }
+
+    std::vector<VibrationMetrics> windows(opts.batch);
+    uint64_t baseMs = epochMs() / 1000 * 1000 - (uint64_t)opts.emitPayloads * opts.batch * 1000;
+    char payload[4096];
+    char id[24];
+
+    for (int n = 0; n < opts.emitPayloads; n++) {
+        int dev = n % opts.devices;
+        snprintf(id, sizeof(id), "%s%06d", opts.idPrefix, dev);
+
+        // Consecutive 1-second windows per device
+        uint64_t t = baseMs + (uint64_t)(n / opts.devices) * opts.batch * 1000;
+        for (int b = 0; b < opts.batch; b++) {
+            windows[b] = VibrationMetrics();
+            imus[dev].window(windows[b]);
+            stampWindow(windows[b], t + (uint64_t)b * 1000);
+        }
+
+        TelemetryHealth health = {4.1f, 35.0f, -60, (uint32_t)(t / 1000 % 86400), 180000};
+        size_t len = opts.batch == 1
+            ? telemetryFormatPayload(payload, sizeof(payload), windows[0], health, id, 0)
+            : telemetryFormatBatchPayload(payload, sizeof(payload), windows.data(), windows.size(), health, id);
+        if (len == 0) {
+            fprintf(stderr, "Payload exceeds %zu bytes, reduce --batch\n", sizeof(payload));
+            return 1;
+        }
+        puts(payload);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    parseArgs(argc, argv);
+
+    if (opts.emitPayloads > 0) {
+        return emitPayloads();
+    }
+
+    raiseFdLimit(opts.devices + 64);
+
+    struct sockaddr_in addr;
+    if (!resolveBroker(addr)) {
+        fprintf(stderr, "Cannot resolve broker %s\n", opts.host);
+        return 1;
+    }
+
+    printf("Fleet: %d devices, %d threads, 1 msg / %d ms each (%.0f msg/s offered), QoS %d, %ds -> %s:%d\n",
+           opts.devices, opts.threads, opts.intervalMs,
+           opts.devices * 1000.0 / opts.intervalMs, opts.qos, opts.durationS, opts.host, opts.port);
+
+    // Partition devices across workers
+    std::vector<Worker> workers(opts.threads);
+    int next = 0;
+    for (int t = 0; t < opts.threads; t++) {
+        int count = opts.devices / opts.threads + (t < opts.devices % opts.threads ? 1 : 0);
+        workers[t].firstIndex = next;
+        workers[t].devices.resize(count);
+        for (int i = 0; i < count; i++) {
+            Device& d = workers[t].devices[i];
+            snprintf(d.id, sizeof(d.id), "%s%06d", opts.idPrefix, next + i);
+            d.topicLen = opts.ingestRule != nullptr
+                ? telemetryFormatIngestTopic(d.topic, sizeof(d.topic), opts.ingestRule, d.id, "telemetry")
+                : telemetryFormatTopic(d.topic, sizeof(d.topic), d.id);
+            if (d.topicLen == 0) {
+                fprintf(stderr, "Invalid topic for %s (rule names are letters, digits and underscores)\n", d.id);
+                return 1;
+            }
+            d.uptimeBase = (uint32_t)((next + i) * 37 % 86400);
+            d.imu.init((uint32_t)(next + i + 1));
+        }
+        next += count;
+    }
+
+    double cpuStart = cpuSeconds();
+    int64_t startUs = nowUs() + 100000;
+    std::vector<std::thread> threads;
+    for (Worker& w : workers) {
+        threads.emplace_back(runWorker, &w, addr, startUs);
+    }
+
+    // Live throughput once a second
+    uint64_t lastPublished = 0;
+    for (int s = 0; s < opts.durationS; s++) {
+        sleep(1);
+        uint64_t total = 0;
+        for (Worker& w : workers) {
+            total += w.publishedLive.load(std::memory_order_relaxed);
+        }
+        printf("t=%3ds  %7.0f msg/s\n", s + 1, (double)(total - lastPublished));
+        fflush(stdout);
+        lastPublished = total;
+    }
+
+    running = false;
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    double cpuUsed = cpuSeconds() - cpuStart;
+    double elapsed = (nowUs() - startUs) / 1e6;
+
+    // Aggregate
+    ThreadStats total;
+    int connected = 0;
+    for (Worker& w : workers) {
+        total.published += w.stats.published;
+        total.acked += w.stats.acked;
+        total.bytes += w.stats.bytes;
+        total.windowFull += w.stats.windowFull;
+        total.errors += w.stats.errors;
+        total.formatNs += w.stats.formatNs;
+        total.ackLatencyUs.insert(total.ackLatencyUs.end(),
+                                  w.stats.ackLatencyUs.begin(), w.stats.ackLatencyUs.end());
+        for (Device& d : w.devices) {
+            if (d.state == DEV_RUNNING) {
+                connected++;
+            }
+        }
+    }
+    std::sort(total.ackLatencyUs.begin(), total.ackLatencyUs.end());
+
+    printf("\n=== Results ===\n");
+    printf("Devices connected : %d / %d (%llu errors)\n", connected, opts.devices, (unsigned long long)total.errors);
+    printf("Published         : %llu (%.0f msg/s, %.2f MB/s)\n",
+           (unsigned long long)total.published, total.published / elapsed, total.bytes / elapsed / 1e6);
+    if (opts.qos > 0) {
+        printf("Acknowledged      : %llu (%llu refused: in-flight window full)\n",
+               (unsigned long long)total.acked, (unsigned long long)total.windowFull);
+        printf("PUBACK latency    : p50 %.2f ms  p90 %.2f ms  p99 %.2f ms  max %.2f ms\n",
+               percentile(total.ackLatencyUs, 0.50) / 1000.0,
+               percentile(total.ackLatencyUs, 0.90) / 1000.0,
+               percentile(total.ackLatencyUs, 0.99) / 1000.0,
+               percentile(total.ackLatencyUs, 1.00) / 1000.0);
+    }
+    if (total.published > 0) {
+        printf("CPU per message   : %.1f us total, %.2f us payload formatting (%.2f CPU-s over %.1f s)\n",
+               cpuUsed * 1e6 / total.published, total.formatNs / 1000.0 / total.published, cpuUsed, elapsed);
+    }
+
+    return connected == opts.devices ? 0 : 1;
+}
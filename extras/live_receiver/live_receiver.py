@@ -0,0 +1,235 @@
+#!/usr/bin/env python3
+"""
+Receiver for the firmware's LAN live stream (src/live_stream.h).
+
+Subscribes by sending a hello to the device every second (the device
+streams to whoever sent the last hello, for LIVE_STREAM_LEASE_MS), maps
+device time to this machine's clock from the pongs, and reports once a
+second:
+
+  - loss: data packets missing from the sequence, and raw samples the
+    device skipped because it fell behind (overruns)
+  - latency: newest sample (or window close) on the device to arrival
+    here, split into on-device queueing and the network leg
+
+Usage:
+    python live_receiver.py 192.168.1.42 --raw --decimation 5
+    python live_receiver.py 192.168.1.42 --raw --csv samples.csv --duration 60
+"""
+
+import argparse
+import csv
+import socket
+import struct
+import time
+
+VERSION = 1
+TYPE_DATA, TYPE_PONG, TYPE_HELLO = 1, 2, 3
+FLAG_RAW = 0x01
+
+HEADER = struct.Struct('<2sBBIq')          # "VL", version, type, seq, sent_us
+HELLO = struct.Struct('<BBHQ')             # flags, sensor, decimation, host_us
+PONG = struct.Struct('<Qq')                # host_us (echo), rx_us
+DATA = struct.Struct('<BBHqII')            # sensor, windows, samples, first_us, period_us, overruns
+WINDOW = struct.Struct('<Iqff')            # seq, close_us, rms_g, peak_g
+SAMPLE = struct.Struct('<hhh')             # x, y, z in mg
+
+HELLO_INTERVAL_S = 1.0
+OFFSET_PONGS = 10                           # Pongs considered for the clock mapping
+
+
+def now_us():
+    return time.monotonic_ns() // 1000
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(p / 100.0 * len(ordered)))]
+
+
+class Clock:
+    """Device esp_timer -> host monotonic time, NTP-style from hello/pong pairs"""
+
+    def __init__(self):
+        self.samples = []   # (round trip, offset), newest last
+
+    def add_pong(self, host_sent, host_received, device_rx, device_tx):
+        round_trip = (host_received - host_sent) - (device_tx - device_rx)
+        offset = ((device_rx - host_sent) + (device_tx - host_received)) / 2
+        self.samples = (self.samples + [(round_trip, offset)])[-OFFSET_PONGS:]
+
+    @property
+    def synced(self):
+        return bool(self.samples)
+
+    def best(self):
+        """(round trip, offset) of the fastest recent exchange: least queueing asymmetry"""
+        return min(self.samples)
+
+    def to_host(self, device_us):
+        return device_us - self.best()[1]
+
+
+class Report:
+    def __init__(self):
+        self.reset()
+        self.total_packets = 0
+        self.total_lost = 0
+
+    def reset(self):
+        self.packets = 0
+        self.lost = 0
+        self.late = 0
+        self.windows = 0
+        self.samples = 0
+        self.latency_ms = []
+        self.queue_ms = []
+        self.network_ms = []
+        self.last_window = None
+
+    def line(self, overruns, clock):
+        expected = self.packets + self.lost
+        loss_pct = 100.0 * self.lost / expected if expected else 0.0
+        text = (f"{self.packets:4d} pkts  lost {self.lost} ({loss_pct:.1f}%)  late {self.late}  "
+                f"{self.samples} samples  overruns {overruns}")
+        if self.latency_ms:
+            text += (f"  latency p50 {percentile(self.latency_ms, 50):.1f} / "
+                     f"p95 {percentile(self.latency_ms, 95):.1f} / max {max(self.latency_ms):.1f} ms"
+                     f"  (device {percentile(self.queue_ms, 50):.1f}, "
+                     f"network {percentile(self.network_ms, 50):.1f})")
+        if clock.synced:
+            text += f"  rtt {clock.best()[0] / 1000:.1f} ms"
+        if self.last_window is not None:
+            text += f"  rms {self.last_window[2]:.4f} g  peak {self.last_window[3]:.4f} g"
+        return text
+
+
+def send_hello(sock, device, args):
+    flags = FLAG_RAW if args.raw else 0
+    packet = HEADER.pack(b'VL', VERSION, TYPE_HELLO, 0, 0) + \
+        HELLO.pack(flags, args.sensor, args.decimation, now_us())
+    sock.sendto(packet, device)
+
+
+def run(args):
+    device = (args.device, args.port)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(('0.0.0.0', 0))
+    sock.settimeout(0.1)
+
+    clock = Clock()
+    report = Report()
+    expected_seq = None
+    overruns = 0
+    writer = None
+    csv_file = None
+    if args.csv:
+        csv_file = open(args.csv, 'w', newline='')
+        writer = csv.writer(csv_file)
+        writer.writerow(['device_us', 'x_mg', 'y_mg', 'z_mg'])
+
+    started = time.monotonic()
+    next_hello = started
+    next_report = started + 1.0
+    print(f"Subscribing to {args.device}:{args.port} "
+          f"(sensor {args.sensor}, raw {'on' if args.raw else 'off'})")
+
+    try:
+        while args.duration == 0 or time.monotonic() - started < args.duration:
+            now = time.monotonic()
+            if now >= next_hello:
+                send_hello(sock, device, args)
+                next_hello = now + HELLO_INTERVAL_S
+            if now >= next_report:
+                print(report.line(overruns, clock))
+                report.reset()
+                next_report = now + 1.0
+
+            try:
+                packet, _ = sock.recvfrom(2048)
+            except socket.timeout:
+                continue
+            received = now_us()
+
+            if len(packet) < HEADER.size:
+                continue
+            magic, version, ptype, seq, sent_us = HEADER.unpack_from(packet)
+            if magic != b'VL' or version != VERSION:
+                continue
+            body = packet[HEADER.size:]
+
+            if ptype == TYPE_PONG and len(body) >= PONG.size:
+                host_sent, device_rx = PONG.unpack_from(body)
+                clock.add_pong(host_sent, received, device_rx, sent_us)
+                continue
+            if ptype != TYPE_DATA or len(body) < DATA.size:
+                continue
+
+            sensor, window_count, sample_count, first_us, period_us, overruns = DATA.unpack_from(body)
+            if len(body) < DATA.size + window_count * WINDOW.size + sample_count * SAMPLE.size:
+                continue
+
+            # Sequence gaps are packets lost on the network; an older seq is a late arrival
+            if expected_seq is None or seq >= expected_seq:
+                lost = seq - expected_seq if expected_seq is not None else 0
+                report.lost += lost
+                report.total_lost += lost
+                expected_seq = seq + 1
+            else:
+                report.late += 1
+                report.total_lost -= 1
+            report.packets += 1
+            report.total_packets += 1
+
+            offset = DATA.size
+            newest_us = None
+            for _ in range(window_count):
+                window = WINDOW.unpack_from(body, offset)
+                offset += WINDOW.size
+                report.windows += 1
+                report.last_window = window
+                newest_us = window[1] if newest_us is None else max(newest_us, window[1])
+
+            for i in range(sample_count):
+                x, y, z = SAMPLE.unpack_from(body, offset)
+                offset += SAMPLE.size
+                if writer is not None:
+                    writer.writerow([first_us + i * period_us, x, y, z])
+            report.samples += sample_count
+            if sample_count:
+                last_sample_us = first_us + (sample_count - 1) * period_us
+                newest_us = last_sample_us if newest_us is None else max(newest_us, last_sample_us)
+
+            if clock.synced and newest_us is not None:
+                report.latency_ms.append((received - clock.to_host(newest_us)) / 1000)
+                report.queue_ms.append((sent_us - newest_us) / 1000)
+                report.network_ms.append((received - clock.to_host(sent_us)) / 1000)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if csv_file is not None:
+            csv_file.close()
+
+    expected = report.total_packets + report.total_lost
+    loss_pct = 100.0 * report.total_lost / expected if expected else 0.0
+    print(f"Total: {report.total_packets} packets, {report.total_lost} lost ({loss_pct:.2f}%), "
+          f"{overruns} samples overrun on the device")
+
+
+def main():
+    parser = argparse.ArgumentParser(description='LAN live stream receiver')
+    parser.add_argument('device', help='device IP address (printed on the serial console at WiFi connect)')
+    parser.add_argument('--port', type=int, default=4210, help='LIVE_STREAM_PORT')
+    parser.add_argument('--sensor', type=int, default=0, help='sensor index (0 = internal IMU)')
+    parser.add_argument('--raw', action='store_true', help='stream decimated raw samples as well as windows')
+    parser.add_argument('--decimation', type=int, default=0,
+                        help='raw samples averaged per sent sample (0 = LIVE_STREAM_DECIMATION)')
+    parser.add_argument('--csv', help='write raw samples to this CSV file')
+    parser.add_argument('--duration', type=float, default=0, help='seconds to run (0 = until Ctrl-C)')
+    run(parser.parse_args())
+
+
+if __name__ == '__main__':
+    main()
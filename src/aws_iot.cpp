@@ -1,22 +1,234 @@
 #include "aws_iot.h"
 #include "config.h"
 #include "secrets.h"
+#include "mqtt_inflight.h"
+#include "diagnostics.h"
+#include "telemetry_format.h"
 
 #include <WiFi.h>
 #include <ArduinoBearSSL.h>
 #include <ArduinoECCX08.h>
 #include <ArduinoMqttClient.h>
+#include <esp_timer.h>
+#include <mbedtls/base64.h>
+#include <string.h>
 #include <time.h>
 
+static void onPubAck(uint16_t packetId);
+static void resendInflight();
+
+// Transparent Client wrapper between MqttClient and its transport
+// ArduinoMqttClient neither reports PUBACKs nor exposes the packet ids it
+// assigns, so both byte streams are scanned as they pass through
+class MqttAckTap : public Client {
+public:
+    explicit MqttAckTap(Client& inner) : _inner(inner), _publishSeen(false), _lastPublishId(0) {}
+
+    int connect(IPAddress ip, uint16_t port) override {
+        resetScanners();
+        return _inner.connect(ip, port);
+    }
+
+    int connect(const char* host, uint16_t port) override {
+        resetScanners();
+        return _inner.connect(host, port);
+    }
+
+    size_t write(uint8_t b) override {
+        scanTx(b);
+        return _inner.write(b);
+    }
+
+    size_t write(const uint8_t* buf, size_t size) override {
+        for (size_t i = 0; i < size; i++) {
+            scanTx(buf[i]);
+        }
+        return _inner.write(buf, size);
+    }
+
+    int available() override { return _inner.available(); }
+
+    int read() override {
+        int c = _inner.read();
+        if (c >= 0) {
+            scanRx((uint8_t)c);
+        }
+        return c;
+    }
+
+    int read(uint8_t* buf, size_t size) override {
+        int n = _inner.read(buf, size);
+        for (int i = 0; i < n; i++) {
+            scanRx(buf[i]);
+        }
+        return n;
+    }
+
+    int peek() override { return _inner.peek(); }
+    void flush() override { _inner.flush(); }
+    void stop() override { _inner.stop(); }
+    uint8_t connected() override { return _inner.connected(); }
+    operator bool() override { return (bool)_inner; }
+
+    // Packet id of the QoS 1 PUBLISH written since the last call
+    bool takePublishId(uint16_t& packetId) {
+        if (!_publishSeen) {
+            return false;
+        }
+        _publishSeen = false;
+        packetId = _lastPublishId;
+        return true;
+    }
+
+private:
+    void resetScanners() {
+        _rx.reset();
+        _tx.reset();
+        _publishSeen = false;
+    }
+
+    void scanTx(uint8_t b) {
+        if (_tx.feed(b) == MqttPacketScanner::EVENT_PUBLISH) {
+            _lastPublishId = _tx.packetId();
+            _publishSeen = true;
+        }
+    }
+
+    void scanRx(uint8_t b) {
+        if (_rx.feed(b) == MqttPacketScanner::EVENT_PUBACK) {
+            onPubAck(_rx.packetId());
+        }
+    }
+
+    Client& _inner;
+    MqttPacketScanner _rx;
+    MqttPacketScanner _tx;
+    bool _publishSeen;
+    uint16_t _lastPublishId;
+};
+
 // Network clients
 static WiFiClient wifiClient;
 static BearSSLClient sslClient(wifiClient);
-static MqttClient mqttClient(sslClient);
+#ifdef MQTT_TEST_BROKER_HOST
+// Plain TCP to a local test broker (no TLS, no secure element)
+static MqttAckTap mqttTap(wifiClient);
+#else
+static MqttAckTap mqttTap(sslClient);
+#endif
+static MqttClient mqttClient(mqttTap);
+
+// Unacknowledged QoS 1 publishes
+static MqttInflightWindow inflight;
+static AwsPublishStats publishStats = {};
+
+// Everything a connect or publish needs, prepared once at boot: reconnects
+// and publishes then do no PEM parsing, topic formatting or allocation
+struct ConnectionProfile {
+    char clientId[33];                                        // ATECC608 serial number (18 hex digits)
+    char topics[AWS_TOPIC_COUNT][MQTT_INFLIGHT_TOPIC_MAX];
+    uint8_t certDer[sizeof(DEVICE_CERTIFICATE) * 3 / 4];      // Decoded DEVICE_CERTIFICATE
+    size_t certDerLen;
+    bool ready;
+};
+
+static const char* const TOPIC_LEAVES[AWS_TOPIC_COUNT] = {"telemetry", "alarms", "diagnostics"};
+
+static ConnectionProfile profile = {};
+static AwsConnectStats connectStats = {};
+
+// With Basic Ingest, telemetry goes straight to its IoT rule; alarms and
+// diagnostics stay on the broker for their subscribers
+static size_t formatTopic(int topic, char* buf, size_t size) {
+#ifdef MQTT_BASIC_INGEST_RULE
+    if (topic == AWS_TOPIC_TELEMETRY) {
+        return telemetryFormatIngestTopic(buf, size, MQTT_BASIC_INGEST_RULE, profile.clientId, TOPIC_LEAVES[topic]);
+    }
+#endif
+    return telemetryFormatDeviceTopic(buf, size, profile.clientId, TOPIC_LEAVES[topic]);
+}
+
+// PEM body between the BEGIN and END lines, base64 decoded
+static bool decodeCertificate(const char* pem, uint8_t* der, size_t size, size_t& len) {
+    static const char BEGIN[] = "-----BEGIN CERTIFICATE-----";
+    static const char END[] = "-----END CERTIFICATE-----";
+
+    const char* body = strstr(pem, BEGIN);
+    if (body == nullptr) {
+        return false;
+    }
+    body += sizeof(BEGIN) - 1;
+    const char* end = strstr(body, END);
+    if (end == nullptr) {
+        return false;
+    }
+
+    return mbedtls_base64_decode(der, size, &len, (const unsigned char*)body, end - body) == 0 && len > 0;
+}
+
+static bool prepareProfile(const String& serial) {
+    int64_t startUs = esp_timer_get_time();
+
+    if (serial.length() == 0 || serial.length() >= sizeof(profile.clientId)) {
+        Serial.println("ERROR: Unexpected ATECC608 serial number");
+        return false;
+    }
+    memcpy(profile.clientId, serial.c_str(), serial.length() + 1);
+
+    for (int t = 0; t < AWS_TOPIC_COUNT; t++) {
+        if (formatTopic(t, profile.topics[t], sizeof(profile.topics[t])) == 0) {
+            Serial.println("ERROR: Topic exceeds MQTT_INFLIGHT_TOPIC_MAX or MQTT_BASIC_INGEST_RULE is not a rule name");
+            return false;
+        }
+    }
+#ifdef MQTT_BASIC_INGEST_RULE
+    Serial.printf("Telemetry via Basic Ingest: %s\n", profile.topics[AWS_TOPIC_TELEMETRY]);
+#endif
+
+    if (!decodeCertificate(DEVICE_CERTIFICATE, profile.certDer, sizeof(profile.certDer), profile.certDerLen)) {
+        Serial.println("ERROR: DEVICE_CERTIFICATE is not a PEM certificate");
+        return false;
+    }
+
+    // BearSSL keeps pointers to the DER and the time callback, and the MQTT
+    // client its ID, across connects
+    ArduinoBearSSL.onGetTime(awsGetTime);
+    sslClient.setEccSlot(PRIVATE_KEY_SLOT, profile.certDer, profile.certDerLen);
+    mqttClient.setId(profile.clientId);
+    mqttClient.setKeepAliveInterval(60 * 1000);  // 60 seconds
+    mqttClient.setConnectionTimeout(10 * 1000);   // 10 seconds
+
+    profile.ready = true;
+    connectStats.prepare_us = esp_timer_get_time() - startUs;
+    Serial.printf("Connection profile ready: %u byte certificate, prepared in %lu us\n",
+                  (unsigned)profile.certDerLen, (unsigned long)connectStats.prepare_us);
+    return true;
+}
+
+// Diagnostics "mqtt" section: delivery counters and connect timing
+static void writeDiagSection(JsonVariant section) {
+    AwsPublishStats mqttStats;
+    awsGetPublishStats(mqttStats);
+    JsonObject mqtt = section.to<JsonObject>();
+    mqtt["published"] = mqttStats.published;
+    mqtt["acked"] = mqttStats.acked;
+    mqtt["retransmitted"] = mqttStats.retransmitted;
+    mqtt["window_full"] = mqttStats.window_full;
+    mqtt["in_flight"] = mqttStats.in_flight;
 
-// Device identifier from ATECC608 serial number
-static String deviceId;
+    // Connect timing; the profile is prepared once at boot
+    AwsConnectStats connStats;
+    awsGetConnectStats(connStats);
+    mqtt["prepare_us"] = connStats.prepare_us;
+    mqtt["connects"] = connStats.connects;
+    mqtt["connect_failures"] = connStats.failures;
+    mqtt["connect_ms"] = connStats.last_ms;
+    mqtt["connect_max_ms"] = connStats.max_ms;
+}
 
 bool awsInitSecureElement() {
+    diagRegisterSection("mqtt", writeDiagSection);
+
     // Initialize I2C for ATECC608 (address 0x35 on Core2 AWS)
     Wire.begin(I2C_SDA_PIN, I2C_SCL_PIN, I2C_FREQUENCY);
 
@@ -28,8 +240,8 @@ bool awsInitSecureElement() {
     }
 
     // Get device serial number (used as Thing name / client ID)
-    deviceId = ECCX08.serialNumber();
-    Serial.printf("ATECC608 initialized. Device ID: %s\n", deviceId.c_str());
+    String serial = ECCX08.serialNumber();
+    Serial.printf("ATECC608 initialized. Device ID: %s\n", serial.c_str());
 
     // Check if device is locked (required for crypto operations)
     if (!ECCX08.locked()) {
@@ -37,11 +249,15 @@ bool awsInitSecureElement() {
         Serial.println("Device may need provisioning.");
     }
 
-    return true;
+    return prepareProfile(serial);
+}
+
+const char* awsGetDeviceId() {
+    return profile.clientId;
 }
 
-String awsGetDeviceId() {
-    return deviceId;
+const char* awsGetTopic(AwsTopic topic) {
+    return profile.topics[topic];
 }
 
 unsigned long awsGetTime() {
@@ -50,27 +266,24 @@ unsigned long awsGetTime() {
 }
 
 bool awsConnect() {
-    if (deviceId.length() == 0) {
+    if (!profile.ready) {
         Serial.println("ERROR: Secure element not initialized");
         return false;
     }
 
-    Serial.println("Configuring BearSSL with ATECC608...");
-
-    // Configure BearSSL to use ATECC608 for private key operations
-    ArduinoBearSSL.onGetTime(awsGetTime);
-    sslClient.setEccSlot(PRIVATE_KEY_SLOT, DEVICE_CERTIFICATE);
-
-    // Set MQTT client ID to device serial number
-    mqttClient.setId(deviceId);
-
-    // Set keep-alive and timeout
-    mqttClient.setKeepAliveInterval(60 * 1000);  // 60 seconds
-    mqttClient.setConnectionTimeout(10 * 1000);   // 10 seconds
+#ifdef MQTT_TEST_BROKER_HOST
+    const char* host = MQTT_TEST_BROKER_HOST;
+    const uint16_t port = MQTT_TEST_BROKER_PORT;
+#else
+    const char* host = AWS_IOT_ENDPOINT;
+    const uint16_t port = MQTT_PORT;
+#endif
 
-    Serial.printf("Connecting to AWS IoT: %s:%d\n", AWS_IOT_ENDPOINT, MQTT_PORT);
+    Serial.printf("Connecting to AWS IoT: %s:%d\n", host, port);
 
-    if (!mqttClient.connect(AWS_IOT_ENDPOINT, MQTT_PORT)) {
+    int64_t connectStartUs = esp_timer_get_time();
+    if (!mqttClient.connect(host, port)) {
+        connectStats.failures++;
         int err = mqttClient.connectError();
         Serial.printf("MQTT connect failed! Error code: %d\n", err);
 
@@ -84,7 +297,17 @@ bool awsConnect() {
         return false;
     }
 
-    Serial.println("Connected to AWS IoT Core!");
+    uint32_t connectMs = (esp_timer_get_time() - connectStartUs) / 1000;
+    connectStats.connects++;
+    connectStats.last_ms = connectMs;
+    if (connectMs > connectStats.max_ms) {
+        connectStats.max_ms = connectMs;
+    }
+    Serial.printf("Connected to AWS IoT Core in %lu ms\n", (unsigned long)connectMs);
+
+    // Clean session: nothing unacknowledged survived the old connection
+    inflight.requeueAll();
+    resendInflight();
     return true;
 }
 
@@ -92,25 +315,141 @@ bool awsIsConnected() {
     return mqttClient.connected();
 }
 
-bool awsPublish(const char* topic, const char* payload) {
+void awsDisconnect() {
+    if (mqttClient.connected()) {
+        mqttClient.stop();
+    }
+    inflight.requeueAll();
+}
+
+static bool writeMessage(const char* topic, const uint8_t* payload, size_t len, uint8_t qos) {
+    // Declare the size up front so the payload is streamed instead of
+    // going through the client's fixed-size (256 byte) TX buffer
+    mqttClient.beginMessage(topic, len, false, qos, false);
+    mqttClient.write(payload, len);
+    return mqttClient.endMessage();
+}
+
+// Write one buffered QoS 1 message and record the packet id it went out with
+// The client assigns a fresh packet id on every write, so a resend is a new
+// PUBLISH (DUP=0): MQTT 3.1.1 only allows DUP=1 with the original id
+static bool sendInflightSlot(int slot) {
+    const MqttInflightSlot& s = inflight.slot(slot);
+
+    if (!writeMessage(s.topic, (const uint8_t*)s.payload, s.length, 1)) {
+        return false;
+    }
+
+    uint16_t packetId;
+    if (!mqttTap.takePublishId(packetId)) {
+        return false;
+    }
+
+    inflight.markSent(slot, packetId, esp_timer_get_time());
+    return true;
+}
+
+// Resend every requeued slot, oldest first
+static void resendInflight() {
+    int slot;
+    while ((slot = inflight.nextUnsent()) >= 0) {
+        if (!sendInflightSlot(slot)) {
+            Serial.println("Retransmit failed, will retry");
+            return;
+        }
+        publishStats.retransmitted++;
+        Serial.printf("Retransmitted %s (packet %u)\n", inflight.slot(slot).topic, inflight.slot(slot).packetId);
+    }
+}
+
+static void onPubAck(uint16_t packetId) {
+    int slot = inflight.findAcked(packetId);
+    if (slot < 0) {
+        return;  // Late ack for a message already resent under a new id
+    }
+
+    const MqttInflightSlot& s = inflight.slot(slot);
+    int64_t nowUs = esp_timer_get_time();
+    diagRecordLatency(LAT_PUBLISH_TO_ACK, nowUs - s.sentUs);
+    if (s.originUs != 0) {
+        diagRecordLatency(LAT_WINDOW_TO_ACK, nowUs - s.originUs);
+    }
+
+    inflight.release(slot);
+    publishStats.acked++;
+}
+
+AwsPublishResult awsPublish(const char* topic, const char* payload, uint8_t qos, int64_t originUs) {
     if (!mqttClient.connected()) {
         Serial.println("Cannot publish: not connected to AWS IoT");
-        return false;
+        return AWS_PUBLISH_FAILED;
     }
 
-    mqttClient.beginMessage(topic);
-    mqttClient.print(payload);
-    int result = mqttClient.endMessage();
+    size_t len = strlen(payload);
 
-    if (result) {
-        Serial.printf("Published to %s (%d bytes)\n", topic, strlen(payload));
-        return true;
+    if (qos > 0) {
+        int slot = inflight.reserve(topic, payload, len, originUs);
+
+        if (slot >= 0) {
+            publishStats.published++;
+
+            // Stays buffered for retransmission even if this write fails
+            if (!sendInflightSlot(slot)) {
+                Serial.printf("Publish failed to %s (queued for retransmit)\n", topic);
+                return AWS_PUBLISH_QUEUED;
+            }
+
+            Serial.printf("Published to %s (%d bytes, QoS 1, packet %u, %u in flight)\n",
+                          topic, len, inflight.slot(slot).packetId, inflight.inFlight());
+            return AWS_PUBLISH_SENT;
+        }
+
+        if (inflight.inFlight() >= MQTT_INFLIGHT_WINDOW) {
+            publishStats.window_full++;
+            Serial.printf("Cannot publish to %s: %d publishes awaiting PUBACK\n", topic, MQTT_INFLIGHT_WINDOW);
+            return AWS_PUBLISH_WINDOW_FULL;
+        }
+
+        // Too large to buffer: sending it QoS 0 would drop the delivery
+        // guarantee without the caller knowing, so refuse it
+        Serial.printf("ERROR: Message too large for QoS 1 buffer (%d byte payload, limit %d)\n", len, MQTT_INFLIGHT_PAYLOAD_MAX);
+        return AWS_PUBLISH_FAILED;
+    }
+
+    if (writeMessage(topic, (const uint8_t*)payload, len, 0)) {
+        Serial.printf("Published to %s (%d bytes)\n", topic, len);
+        return AWS_PUBLISH_SENT;
     } else {
         Serial.printf("Publish failed to %s\n", topic);
-        return false;
+        return AWS_PUBLISH_FAILED;
     }
 }
 
+void awsGetPublishStats(AwsPublishStats& stats) {
+    stats = publishStats;
+    stats.in_flight = inflight.inFlight();
+}
+
+void awsGetConnectStats(AwsConnectStats& stats) {
+    stats = connectStats;
+}
+
 void awsMaintain() {
+    // PUBACKs are picked up by mqttTap while the client reads
     mqttClient.poll();
+
+    if (!mqttClient.connected()) {
+        return;
+    }
+
+    // A lost PUBACK, or a first write that failed while the socket still
+    // looked connected, would otherwise pin its slot until the next reconnect
+    inflight.requeueExpired(esp_timer_get_time(), MQTT_ACK_TIMEOUT_MS * 1000LL);
+    if (inflight.nextUnsent() >= 0) {
+        resendInflight();
+    }
+}
+
+bool awsCanPublish(uint8_t qos) {
+    return mqttClient.connected() && (qos == 0 || inflight.inFlight() < MQTT_INFLIGHT_WINDOW);
 }
@@ -7,25 +7,82 @@
 // Returns true if initialization successful
 bool awsInitSecureElement();
 
+// Per-device MQTT topics, formatted once at boot
+enum AwsTopic {
+    AWS_TOPIC_TELEMETRY = 0,   // dt/vibration/{device_id}/telemetry ($aws/rules/{rule}/... with MQTT_BASIC_INGEST_RULE)
+    AWS_TOPIC_ALARMS,          // dt/vibration/{device_id}/alarms
+    AWS_TOPIC_DIAGNOSTICS,     // dt/vibration/{device_id}/diagnostics
+    AWS_TOPIC_COUNT
+};
+
 // Get the device ID (ATECC608 serial number)
-// Used as Thing name and MQTT client ID
-String awsGetDeviceId();
+// Used as Thing name and MQTT client ID; "" before awsInitSecureElement()
+const char* awsGetDeviceId();
+
+// Get a topic from the connection profile ("" before awsInitSecureElement())
+const char* awsGetTopic(AwsTopic topic);
 
 // Connect to AWS IoT Core via MQTTS
-// Must call awsInitSecureElement() first
+// Must call awsInitSecureElement() first, which prepares the connection
+// profile (client ID, topics, DER certificate) so connecting parses nothing
 // Returns true if connected
 bool awsConnect();
 
+// Connection timing (cumulative since boot)
+struct AwsConnectStats {
+    uint32_t prepare_us;     // One-time profile preparation at boot
+    uint32_t connects;       // Successful connects, including reconnects
+    uint32_t failures;       // Failed connect attempts
+    uint32_t last_ms;        // Duration of the latest successful connect (TCP, TLS, MQTT CONNECT)
+    uint32_t max_ms;         // Slowest successful connect
+};
+
 // Check if currently connected to AWS IoT
 bool awsIsConnected();
 
+// Close the MQTT connection before the radio goes off; unacknowledged
+// QoS 1 publishes stay buffered and are resent after the next awsConnect()
+void awsDisconnect();
+
+// QoS 1 delivery counters (cumulative since boot)
+struct AwsPublishStats {
+    uint32_t published;      // QoS 1 publishes accepted into the in-flight window
+    uint32_t acked;          // PUBACKs received
+    uint32_t retransmitted;  // Resends after a reconnect or ack timeout
+    uint32_t window_full;    // Publishes refused because the window was full
+    uint8_t in_flight;       // Currently unacknowledged
+};
+
+// Outcome of awsPublish(). SENT and QUEUED both mean the message is now
+// owned by the client: callers must not publish it again
+enum AwsPublishResult {
+    AWS_PUBLISH_FAILED = 0,   // Dropped: not connected, a QoS 0 write failed, or a QoS 1
+                              // message larger than MQTT_INFLIGHT_PAYLOAD_MAX
+    AWS_PUBLISH_SENT,         // Written to the socket
+    AWS_PUBLISH_QUEUED,       // QoS 1: buffered, first write failed; awsMaintain() retries it
+    AWS_PUBLISH_WINDOW_FULL   // QoS 1: MQTT_INFLIGHT_WINDOW publishes await PUBACK; try again later
+};
+
 // Publish a message to a topic
-// Returns true if published successfully
-bool awsPublish(const char* topic, const char* payload);
+// QoS 1 messages are buffered until the broker's PUBACK arrives and are
+// resent after a reconnect or MQTT_ACK_TIMEOUT_MS; originUs (esp_timer time the data was
+// measured, 0 if unknown) feeds the window->ack latency histogram
+AwsPublishResult awsPublish(const char* topic, const char* payload, uint8_t qos = 0, int64_t originUs = 0);
+
+// Get QoS 1 delivery counters
+void awsGetPublishStats(AwsPublishStats& stats);
+
+// Get connection timing
+void awsGetConnectStats(AwsConnectStats& stats);
 
 // Maintain MQTT connection (call periodically from main loop)
 void awsMaintain();
 
+// True if awsPublish() would accept a message at this QoS now (connected
+// and, for QoS 1, an in-flight slot free); slots free as awsMaintain()
+// picks up PUBACKs
+bool awsCanPublish(uint8_t qos);
+
 // Get time from WiFi/NTP (used by BearSSL for cert validation)
 unsigned long awsGetTime();
 
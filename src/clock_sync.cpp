@@ -0,0 +1,133 @@
+#include "clock_sync.h"
+#include "config.h"
+#include "diagnostics.h"
+#include <esp_sntp.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+
+// Model: utc = syncUtcUs + (timer - syncTimerUs) * (1 + driftPpm / 1e6),
+// plus a slew term that works off the last sync's correction over slewSpanUs
+static int64_t syncTimerUs = 0;
+static int64_t syncUtcUs = 0;
+static int64_t slewUs = 0;
+static int64_t slewSpanUs = 0;
+static float driftPpm = 0.0f;
+static bool synced = false;
+static bool driftKnown = false;
+static uint32_t syncCount = 0;
+static int32_t lastErrorUs = 0;
+
+// Written from the SNTP (tcpip) task, read from the IMU task
+static portMUX_TYPE clockLock = portMUX_INITIALIZER_UNLOCKED;
+
+static int64_t modelUtcUs(int64_t timerUs) {
+    int64_t elapsed = timerUs - syncTimerUs;
+    int64_t utc = syncUtcUs + elapsed + (int64_t)(elapsed * (double)driftPpm * 1e-6);
+
+    // Readings from before the sync keep the previous line's offset
+    if (elapsed <= 0) {
+        utc += slewUs;
+    } else if (elapsed < slewSpanUs) {
+        utc += slewUs - (int64_t)((double)slewUs * elapsed / slewSpanUs);
+    }
+    return utc;
+}
+
+static void recordSync(int64_t timerUs, int64_t utcUs, bool fromSntp) {
+    portENTER_CRITICAL(&clockLock);
+
+    int64_t errorUs = 0;
+    if (synced) {
+        int64_t elapsed = timerUs - syncTimerUs;
+        errorUs = modelUtcUs(timerUs) - utcUs;
+        lastErrorUs = (int32_t)constrain(errorUs, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+
+        // Rate error over a long enough baseline that NTP jitter (a few
+        // ms) stays well below the drift being measured
+        if (elapsed >= CLOCK_DRIFT_MIN_BASELINE_MS * 1000LL) {
+            float measured = (float)((double)((utcUs - syncUtcUs) - elapsed) / elapsed * 1e6);
+            if (fabsf(measured) <= CLOCK_DRIFT_MAX_PPM) {
+                driftPpm = driftKnown ? driftPpm + CLOCK_DRIFT_SMOOTHING * (measured - driftPpm) : measured;
+                driftKnown = true;
+            }
+        }
+    }
+
+    syncTimerUs = timerUs;
+    syncUtcUs = utcUs;
+
+    // Slew a small correction in at CLOCK_SLEW_RATE_PPM so window stamps
+    // stay continuous and monotonic; a larger one steps the clock
+    int64_t errorAbsUs = errorUs < 0 ? -errorUs : errorUs;
+    if (errorAbsUs <= CLOCK_SLEW_MAX_US) {
+        slewUs = errorUs;
+        slewSpanUs = errorAbsUs * 1000000LL / CLOCK_SLEW_RATE_PPM;
+    } else {
+        slewUs = 0;
+        slewSpanUs = 0;
+    }
+    synced = true;
+    if (fromSntp) {
+        syncCount++;
+    }
+
+    portEXIT_CRITICAL(&clockLock);
+}
+
+static void onTimeSync(struct timeval* tv) {
+    recordSync(esp_timer_get_time(), (int64_t)tv->tv_sec * 1000000LL + tv->tv_usec, true);
+}
+
+// Diagnostics "clock" section: esp_timer drift against NTP
+static void writeDiagSection(JsonVariant section) {
+    ClockStats clock;
+    clockGetStats(clock);
+    JsonObject clk = section.to<JsonObject>();
+    clk["synced"] = clock.synced;
+    clk["syncs"] = clock.syncs;
+    clk["drift_ppm"] = serialized(String(clock.drift_ppm, 2));
+    clk["last_error_us"] = clock.last_error_us;
+    clk["since_sync_s"] = clock.since_sync_s;
+}
+
+void clockInit() {
+    diagRegisterSection("clock", writeDiagSection);
+    sntp_set_time_sync_notification_cb(onTimeSync);
+    sntp_set_sync_interval(CLOCK_SYNC_INTERVAL_MS);
+}
+
+uint64_t clockUtcUs(int64_t timerUs) {
+    portENTER_CRITICAL(&clockLock);
+    bool haveModel = synced;
+    int64_t utc = haveModel ? modelUtcUs(timerUs) : 0;
+    portEXIT_CRITICAL(&clockLock);
+
+    if (!haveModel) {
+        // The first sync notification can be missed (time set before
+        // clockInit); seed the model from system time once it is valid
+        struct timeval tv;
+        gettimeofday(&tv, nullptr);
+        if (tv.tv_sec < CLOCK_MIN_VALID_EPOCH_S) {
+            return 0;
+        }
+        recordSync(esp_timer_get_time(), (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec, false);
+
+        portENTER_CRITICAL(&clockLock);
+        utc = modelUtcUs(timerUs);
+        portEXIT_CRITICAL(&clockLock);
+    }
+
+    return (uint64_t)utc;
+}
+
+void clockGetStats(ClockStats& stats) {
+    portENTER_CRITICAL(&clockLock);
+    stats.synced = synced;
+    stats.syncs = syncCount;
+    stats.drift_ppm = driftPpm;
+    stats.last_error_us = lastErrorUs;
+    int64_t sinceUs = synced ? esp_timer_get_time() - syncTimerUs : 0;
+    portEXIT_CRITICAL(&clockLock);
+
+    stats.since_sync_s = (uint32_t)(sinceUs / 1000000);
+}
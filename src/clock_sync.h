@@ -0,0 +1,32 @@
+#ifndef CLOCK_SYNC_H
+#define CLOCK_SYNC_H
+
+#include <Arduino.h>
+
+// UTC timebase for window stamping. Each SNTP sync records a pair of
+// (esp_timer, UTC) readings; the esp_timer's rate error against NTP is
+// estimated from successive pairs, so between syncs UTC is extrapolated
+// from the hardware timer instead of following system-time steps. The
+// correction a sync brings is slewed in rather than stepped, unless it is
+// larger than CLOCK_SLEW_MAX_US.
+
+// Clock model statistics
+struct ClockStats {
+    bool synced;              // At least one (timer, UTC) pair recorded
+    uint32_t syncs;           // SNTP syncs since boot
+    float drift_ppm;          // esp_timer rate error corrected for (+ = timer slow)
+    int32_t last_error_us;    // Model prediction minus NTP time at the last sync
+    uint32_t since_sync_s;    // Seconds since the last sync
+};
+
+// Hook SNTP sync notifications (call before configTime())
+void clockInit();
+
+// UTC time in microseconds for an esp_timer_get_time() reading
+// Returns 0 before the clock is synced
+uint64_t clockUtcUs(int64_t timerUs);
+
+// Get clock model statistics
+void clockGetStats(ClockStats& stats);
+
+#endif // CLOCK_SYNC_H
@@ -13,22 +13,128 @@
 // IMU Sampling Configuration
 #define IMU_SAMPLE_RATE_HZ   500
 #define IMU_WINDOW_SAMPLES   500   // 1 second window at 500Hz
+#define IMU_HOP_SAMPLES      125   // Sliding: a new window every 250 ms (= IMU_WINDOW_SAMPLES for disjoint windows)
 #define IMU_TASK_STACK_SIZE  4096
 #define IMU_TASK_PRIORITY    5
 #define IMU_TASK_CORE        1
+#define IMU_HISTORY_WINDOWS  14400 // Recent windows kept for trend/batching/backfill (1 h at 250 ms hop, PSRAM)
+#define SPECTRUM_BANDS       32    // Spectrum bands per window (250 Hz / 32 = 7.8 Hz)
+#define IMU_FIFO_DRAIN_MS    100   // FIFO read period during a burst (1 KB FIFO holds 73 samples)
+#define IMU_BURST_WAIT_STEP_MS 100 // Longest single delay while waiting for the next burst
+#define IMU_INTERNAL_NAME    "internal"  // Sensor name in telemetry and diagnostics
+
+// External sensors on the Grove port (Port A), each with its own sampler.
+// Rates must divide IMU_SAMPLE_RATE_HZ (the sampling task's tick); windows
+// are at most IMU_WINDOW_SAMPLES, and a hop must divide one second.
+// Burst sampling (duty-cycle profile) covers the internal IMU only.
+#define IMU_EXT_MPU6886              0     // 1 = M5Stack IMU Unit (MPU6886 @ 0x68)
+#define IMU_EXT_MPU6886_NAME         "grove_imu"
+#define IMU_EXT_MPU6886_RATE_HZ      500
+#define IMU_EXT_MPU6886_WINDOW       500   // Samples (1 s)
+#define IMU_EXT_MPU6886_HOP          125   // Samples (250 ms)
+#define IMU_EXT_ADXL345              0     // 1 = ADXL345 accelerometer unit @ 0x53 (no gyro)
+#define IMU_EXT_ADXL345_NAME         "grove_accel"
+#define IMU_EXT_ADXL345_RATE_HZ      250
+#define IMU_EXT_ADXL345_WINDOW       250   // Samples (1 s)
+#define IMU_EXT_ADXL345_HOP          125   // Samples (500 ms)
+#define IMU_EXT_HISTORY_WINDOWS      2400  // Per external sensor (10 min at 250 ms hop, PSRAM)
+#define IMU_MAX_SENSORS              (1 + IMU_EXT_MPU6886 + IMU_EXT_ADXL345)
 
 // Telemetry Configuration
 #define TELEMETRY_INTERVAL_MS  5000  // Publish every 5 seconds
+#define TELEMETRY_BATCH_MAX    8     // Windows considered per batched JSON payload
+#define TELEMETRY_BLOCK_ENCODING 1   // Batched uploads as delta/varint blocks (0 = JSON windows array)
+#define TELEMETRY_BLOCK_MAX    32    // Windows considered per block payload
 #define MQTT_PORT              8883
 
+// MQTT Delivery Configuration
+#define MQTT_TELEMETRY_QOS         1    // 0 = fire-and-forget, 1 = PUBACK tracked
+#define MQTT_INFLIGHT_WINDOW       4    // Unacknowledged QoS 1 publishes allowed
+#define MQTT_INFLIGHT_PAYLOAD_MAX  1536 // Bytes buffered per in-flight publish
+#define MQTT_INFLIGHT_TOPIC_MAX    128  // Bytes buffered per in-flight topic (Basic Ingest prefix + device topic)
+#define MQTT_ACK_TIMEOUT_MS        15000  // Resend if no PUBACK within this time
+
+// Diagnostics Configuration
+#define DIAG_SAMPLE_INTERVAL_MS   10000  // Task/heap snapshot every 10 seconds
+#define DIAG_PUBLISH_INTERVAL_MS  60000  // Publish diagnostics every minute
+
+// Power Configuration
+#define POWER_PROFILE_CONTINUOUS  0   // Sample, display and stay on the network continuously
+#define POWER_PROFILE_DUTY_CYCLE  1   // Burst sampling, light sleep, batched uploads
+#ifndef POWER_PROFILE
+#define POWER_PROFILE             POWER_PROFILE_CONTINUOUS  // Override with -DPOWER_PROFILE=1
+#endif
+#define POWER_BURST_INTERVAL_MS   60000   // Duty cycle: one window per minute
+#define POWER_UPLOAD_INTERVAL_MS  600000  // Duty cycle: batched upload every 10 minutes
+#define POWER_UPLOAD_AWAKE_MS     3000    // Radio kept out of modem sleep after an upload
+#define POWER_UPLOAD_MAX_MS       45000   // Longest batched upload; leftover windows go with the next one
+#define POWER_DISPLAY_TIMEOUT_MS  30000   // Duty cycle: display off after 30 s without touch
+#define POWER_LOOP_DELAY_MS       100     // Duty cycle: loop() idle delay
+// Explicit light sleep, used when the framework has no tickless idle.
+// Light sleep drops the WiFi association, so the radio is off between
+// uploads and comes back up POWER_RADIO_LEAD_MS before each one
+#define POWER_SLEEP_MIN_MS        200     // Shorter idle periods are a plain delay
+#define POWER_SLEEP_MAX_MS        30000   // Longest single light sleep
+#define POWER_SLEEP_MARGIN_MS     50      // Wake this long before an IMU burst
+#define POWER_RADIO_LEAD_MS       15000   // WiFi + MQTT reconnect time allowed before an upload
+#define POWER_RADIO_MAX_ON_MS     60000   // Radio off after this long even with publishes unacknowledged
+#define POWER_TOUCH_WAKE_GPIO     39      // Core2 touch controller interrupt (active low) wakes from sleep
+#define POWER_SAMPLE_INTERVAL_MS  10000   // Coulomb counter read period
+
+// Clock Configuration (window alignment, see clock_sync.h)
+#define CLOCK_SYNC_INTERVAL_MS       900000  // SNTP resync every 15 minutes
+#define CLOCK_DRIFT_MIN_BASELINE_MS  600000  // Shortest sync-to-sync span used to measure drift
+#define CLOCK_DRIFT_MAX_PPM          200.0f  // Ignore rate estimates beyond crystal tolerance
+#define CLOCK_DRIFT_SMOOTHING        0.5f    // Weight of each new drift estimate
+#define CLOCK_SLEW_RATE_PPM          500     // Rate at which a sync's correction is worked off
+#define CLOCK_SLEW_MAX_US            250000  // Larger corrections step the clock (slewing would outlast a sync interval)
+#define CLOCK_MIN_VALID_EPOCH_S      (8 * 3600 * 2)  // System time below this has not been set yet
+
+// Fault Classifier Configuration (see fault_classifier.h)
+#define FAULT_CLASSIFIER_ENABLED  1      // Classify each window's spectrum (once per window length)
+#define FAULT_MODEL_MAX_BYTES     8192   // Flash budget for the compiled-in model (checked at build)
+#define FAULT_MAX_COMPARISONS     128    // Inference bound: trees x depth (checked at build)
+#define FAULT_CLASSIFY_BUDGET_US  300    // Features + inference per window on device; over budget is counted
+
+// Live Stream Configuration (LAN commissioning over UDP, see live_stream.h)
+#define LIVE_STREAM_ENABLED          0      // 1 = serve receivers on LIVE_STREAM_PORT (continuous profile only)
+#define LIVE_STREAM_PORT             4210
+#define LIVE_STREAM_RATE_HZ          25     // Data packet rate cap
+#define LIVE_STREAM_POLL_MS          5      // Hello polling period (pong timing accuracy)
+#define LIVE_STREAM_DECIMATION       5      // Default raw samples averaged per sent sample (100 Hz at 500 Hz)
+#define LIVE_STREAM_MAX_RAW_HZ       250    // Cap on the sent raw sample rate
+#define LIVE_STREAM_LEASE_MS         5000   // Stop streaming this long after the receiver's last hello
+#define LIVE_STREAM_PACKET_MAX       1400   // Bytes per datagram (below the WiFi MTU)
+#define LIVE_STREAM_TASK_STACK_SIZE  4096
+#define LIVE_STREAM_TASK_PRIORITY    1      // Below the sampler and loop()
+#define LIVE_STREAM_TASK_CORE        0      // Off the sampling/MQTT core
+
 // WiFi Configuration
 #define WIFI_CONNECT_TIMEOUT_MS  30000
 #define WIFI_RETRY_DELAY_MS      5000
 
 // Display Configuration
-#define DISPLAY_UPDATE_INTERVAL_MS  500
+#define DISPLAY_UPDATE_INTERVAL_MS  500   // Status hand-off from loop() to the display task
+#define DISPLAY_FRAME_INTERVAL_MS   50    // Display task frame period (20 fps)
+#define DISPLAY_TASK_STACK_SIZE     6144
+#define DISPLAY_TASK_PRIORITY       1
+#define DISPLAY_TASK_CORE           0     // Keep SPI work off the loop/MQTT core
+#define DISPLAY_TILE_W              32    // Dirty-region granularity (pixels)
+#define DISPLAY_TILE_H              16
+#define DISPLAY_RENDER_BUDGET_US    8000  // Per-frame render budget (backfill yields past it)
+
+// Memory Arenas (PSRAM, reserved at boot; see mem_arena.h)
+#define MEM_ARENA_IMU_KB      (1140 + 200 * (IMU_MAX_SENSORS - 1))  // Per sensor: sample ring (~10 KB) + history x 80 B (checked by a static_assert in imu_sampler.cpp)
+#define MEM_ARENA_DISPLAY_KB  160   // 320 x 240 x 16-bit shown-frame copy
+#define MEM_ARENA_JSON_KB     16    // Diagnostics JsonDocument
 
 // MQTT Topic Prefix
 #define MQTT_TOPIC_PREFIX  "dt/vibration/"
 
+// AWS IoT Basic Ingest: publishes to MQTT_BASIC_INGEST_PREFIX{rule}/... go
+// straight to that IoT rule without the broker. Enabled per device by
+// defining MQTT_BASIC_INGEST_RULE in secrets.h
+#define MQTT_BASIC_INGEST_PREFIX  "$aws/rules/"
+#define MQTT_BASIC_INGEST_RULE_MAX  128   // AWS IoT rule name limit
+
 #endif // CONFIG_H
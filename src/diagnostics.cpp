@@ -0,0 +1,384 @@
+#include "diagnostics.h"
+#include "config.h"
+#include "aws_iot.h"
+#include "imu_sampler.h"
+#include "mem_arena.h"
+#include <ArduinoJson.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+// Per-task CPU share needs FreeRTOS run-time stats; stack and heap
+// figures only need the trace facility
+#define DIAG_HAS_TASK_LIST      (configUSE_TRACE_FACILITY == 1)
+#define DIAG_HAS_RUNTIME_STATS  (DIAG_HAS_TASK_LIST && configGENERATE_RUN_TIME_STATS == 1)
+
+// Latest snapshot (guarded by diagMutex) and scratch space for sampling
+static DiagnosticsSnapshot latestSnap = {};
+static DiagnosticsSnapshot workSnap = {};
+static SemaphoreHandle_t diagMutex = nullptr;
+
+// Loop timing accumulators (only touched from the loop task)
+static int64_t loopStartUs = 0;
+static uint64_t loopTotalUs = 0;
+static uint32_t loopMaxUs = 0;
+static uint32_t loopCount = 0;
+
+// Instrumentation's own time since the previous snapshot (loop task only)
+static int64_t selfUs = 0;
+static int64_t lastSampleUs = 0;
+
+// Pipeline latency histograms (only touched from the loop task)
+static LatencyHistogram latency[LAT_STAGE_COUNT];
+
+static const char* const LATENCY_STAGE_NAMES[LAT_STAGE_COUNT] = {
+    "window_to_serialize",
+    "serialize",
+    "publish",
+    "window_to_ack",
+    "publish_to_ack",
+};
+
+// Module sections registered with diagRegisterSection()
+static struct {
+    const char* name;
+    DiagSectionWriter writer;
+} sections[DIAG_MAX_SECTIONS];
+static uint8_t sectionCount = 0;
+
+#if DIAG_HAS_TASK_LIST
+static TaskStatus_t taskStatus[DIAG_MAX_TASKS];
+#endif
+
+#if DIAG_HAS_RUNTIME_STATS
+// Run-time counters from the previous sample, keyed by task handle
+static struct {
+    TaskHandle_t handle;
+    uint32_t runTime;
+} prevRunTime[DIAG_MAX_TASKS];
+static uint8_t prevRunTimeCount = 0;
+static uint32_t prevTotalRunTime = 0;
+
+static uint32_t lookupPrevRunTime(TaskHandle_t handle, uint32_t fallback) {
+    for (uint8_t i = 0; i < prevRunTimeCount; i++) {
+        if (prevRunTime[i].handle == handle) {
+            return prevRunTime[i].runTime;
+        }
+    }
+    // New task: report zero load for its first interval
+    return fallback;
+}
+#endif
+
+void diagInit() {
+    diagMutex = xSemaphoreCreateMutex();
+
+    if (diagMutex == nullptr) {
+        Serial.println("ERROR: Failed to create diagnostics mutex");
+        return;
+    }
+
+#if !DIAG_HAS_RUNTIME_STATS
+    Serial.println("Diagnostics: FreeRTOS run-time stats disabled, per-task CPU unavailable");
+#endif
+}
+
+bool diagRegisterSection(const char* name, DiagSectionWriter writer) {
+    for (uint8_t i = 0; i < sectionCount; i++) {
+        if (sections[i].writer == writer) {
+            return true;
+        }
+    }
+    if (sectionCount >= DIAG_MAX_SECTIONS) {
+        Serial.printf("ERROR: No room for diagnostics section %s\n", name);
+        return false;
+    }
+    sections[sectionCount].name = name;
+    sections[sectionCount].writer = writer;
+    sectionCount++;
+    return true;
+}
+
+void diagLoopBegin() {
+    loopStartUs = esp_timer_get_time();
+    selfUs += esp_timer_get_time() - loopStartUs;
+}
+
+void diagLoopEnd() {
+    int64_t endUs = esp_timer_get_time();
+    uint32_t elapsed = (uint32_t)(endUs - loopStartUs);
+
+    loopTotalUs += elapsed;
+    loopCount++;
+    if (elapsed > loopMaxUs) {
+        loopMaxUs = elapsed;
+    }
+    selfUs += esp_timer_get_time() - endUs;
+}
+
+void diagRecordLatency(LatencyStage stage, int64_t us) {
+    if (stage >= LAT_STAGE_COUNT || us < 0) {
+        return;
+    }
+    int64_t startUs = esp_timer_get_time();
+
+    uint32_t value = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+
+    // log2 bucket: 0 for < 64 us, then one bucket per doubling
+    uint32_t scaled = value / LATENCY_BUCKET_US;
+    int idx = scaled == 0 ? 0 : 32 - __builtin_clz(scaled);
+    if (idx >= LATENCY_BUCKETS) {
+        idx = LATENCY_BUCKETS - 1;
+    }
+
+    LatencyHistogram& hist = latency[stage];
+    hist.buckets[idx]++;
+    hist.count++;
+    if (value > hist.max_us) {
+        hist.max_us = value;
+    }
+    selfUs += esp_timer_get_time() - startUs;
+}
+
+uint32_t diagLatencyPercentile(const LatencyHistogram& hist, float pct) {
+    if (hist.count == 0) {
+        return 0;
+    }
+
+    uint32_t target = (uint32_t)ceilf(pct * hist.count);
+    uint32_t seen = 0;
+
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += hist.buckets[i];
+        if (seen >= target && hist.buckets[i] > 0) {
+            // Never report more than the worst value actually observed
+            uint32_t upper = (uint32_t)LATENCY_BUCKET_US << i;
+            return upper < hist.max_us ? upper : hist.max_us;
+        }
+    }
+
+    return hist.max_us;
+}
+
+static void sampleTasks(DiagnosticsSnapshot& snap) {
+    snap.taskCount = 0;
+    snap.core_load_pct[0] = -1.0f;
+    snap.core_load_pct[1] = -1.0f;
+
+#if DIAG_HAS_TASK_LIST
+    uint32_t totalRunTime = 0;
+    UBaseType_t count = uxTaskGetSystemState(taskStatus, DIAG_MAX_TASKS, &totalRunTime);
+
+    if (count == 0) {
+        // More tasks than DIAG_MAX_TASKS; FreeRTOS fills nothing
+        return;
+    }
+
+#if DIAG_HAS_RUNTIME_STATS
+    uint32_t elapsed = totalRunTime - prevTotalRunTime;
+    bool haveDelta = (prevTotalRunTime != 0) && (elapsed > 0);
+#endif
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        TaskDiag& t = snap.tasks[snap.taskCount++];
+        strlcpy(t.name, taskStatus[i].pcTaskName, sizeof(t.name));
+        t.stack_free = taskStatus[i].usStackHighWaterMark;
+        t.cpu_pct = -1.0f;
+
+#if DIAG_HAS_RUNTIME_STATS
+        if (haveDelta) {
+            uint32_t prev = lookupPrevRunTime(taskStatus[i].xHandle, taskStatus[i].ulRunTimeCounter);
+            t.cpu_pct = 100.0f * (taskStatus[i].ulRunTimeCounter - prev) / elapsed;
+
+            // Core load is whatever its idle task did not get
+            for (int core = 0; core < portNUM_PROCESSORS && core < 2; core++) {
+                if (taskStatus[i].xHandle == xTaskGetIdleTaskHandleForCPU(core)) {
+                    snap.core_load_pct[core] = constrain(100.0f - t.cpu_pct, 0.0f, 100.0f);
+                }
+            }
+        }
+#endif
+    }
+
+#if DIAG_HAS_RUNTIME_STATS
+    for (UBaseType_t i = 0; i < count; i++) {
+        prevRunTime[i].handle = taskStatus[i].xHandle;
+        prevRunTime[i].runTime = taskStatus[i].ulRunTimeCounter;
+    }
+    prevRunTimeCount = count;
+    prevTotalRunTime = totalRunTime;
+#endif
+#endif // DIAG_HAS_TASK_LIST
+}
+
+void diagSample() {
+    if (diagMutex == nullptr) {
+        return;
+    }
+
+    int64_t startUs = esp_timer_get_time();
+    DiagnosticsSnapshot& snap = workSnap;
+
+    sampleTasks(snap);
+
+    // Internal heap (what WiFi/TLS allocate from): fragmentation = how
+    // much of the free space is unusable for a single allocation
+    snap.free_heap = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    snap.min_free_heap = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    snap.largest_free_block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    snap.free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    snap.heap_frag_pct = snap.free_heap > 0
+        ? 100.0f * (1.0f - (float)snap.largest_free_block / snap.free_heap)
+        : 0.0f;
+
+    TaskHandle_t imuTask = imuGetTaskHandle();
+    snap.imu_stack_free = imuTask ? uxTaskGetStackHighWaterMark(imuTask) : 0;
+    snap.loop_stack_free = uxTaskGetStackHighWaterMark(nullptr);  // Called from loop()
+
+    // Loop timing since the previous sample
+    snap.loop_count = loopCount;
+    snap.loop_avg_us = loopCount > 0 ? (uint32_t)(loopTotalUs / loopCount) : 0;
+    snap.loop_max_us = loopMaxUs;
+    loopTotalUs = 0;
+    loopMaxUs = 0;
+    loopCount = 0;
+
+    memcpy(snap.latency, latency, sizeof(latency));
+
+    snap.timestamp = millis();
+    snap.valid = true;
+
+    // Instrumentation overhead: everything diagnostics spent since the
+    // previous snapshot, this one included, relative to the elapsed time
+    int64_t endUs = esp_timer_get_time();
+    snap.sample_cost_us = (uint32_t)(endUs - startUs);
+    selfUs += snap.sample_cost_us;
+    snap.self_us = (uint32_t)selfUs;
+    snap.overhead_pct = endUs > lastSampleUs ? 100.0f * selfUs / (endUs - lastSampleUs) : 0.0f;
+    selfUs = 0;
+    lastSampleUs = endUs;
+
+    if (xSemaphoreTake(diagMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        latestSnap = snap;
+        xSemaphoreGive(diagMutex);
+    }
+}
+
+bool diagGetSnapshot(DiagnosticsSnapshot& snap) {
+    if (diagMutex == nullptr) {
+        return false;
+    }
+
+    bool success = false;
+
+    if (xSemaphoreTake(diagMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        if (latestSnap.valid) {
+            snap = latestSnap;
+            success = true;
+        }
+        xSemaphoreGive(diagMutex);
+    }
+
+    return success;
+}
+
+String diagBuildPayload(const DiagnosticsSnapshot& snap, const char* deviceId) {
+    JsonDocument doc(memJsonAllocator());
+
+    doc["device_id"] = deviceId;
+    doc["timestamp"] = awsGetTime();
+
+    // CPU load per core
+    JsonObject cpu = doc["cpu"].to<JsonObject>();
+    if (snap.core_load_pct[0] >= 0) {
+        cpu["core0_pct"] = serialized(String(snap.core_load_pct[0], 1));
+        cpu["core1_pct"] = serialized(String(snap.core_load_pct[1], 1));
+    }
+    cpu["loop_avg_us"] = snap.loop_avg_us;
+    cpu["loop_max_us"] = snap.loop_max_us;
+    cpu["loop_count"] = snap.loop_count;
+
+    // Heap health
+    JsonObject heap = doc["heap"].to<JsonObject>();
+    heap["free"] = snap.free_heap;
+    heap["min_free"] = snap.min_free_heap;
+    heap["largest_block"] = snap.largest_free_block;
+    heap["frag_pct"] = serialized(String(snap.heap_frag_pct, 1));
+    heap["free_psram"] = snap.free_psram;
+
+    // PSRAM arenas for the big buffers
+    JsonArray arenaList = doc["arenas"].to<JsonArray>();
+    for (int i = 0; i < ARENA_COUNT; i++) {
+        MemArenaStats arena;
+        memGetArenaStats((MemArena)i, arena);
+        JsonObject a = arenaList.add<JsonObject>();
+        a["name"] = arena.name;
+        a["capacity"] = arena.capacity;
+        a["used"] = arena.used;
+        a["peak"] = arena.peak;
+        a["failures"] = arena.failures;
+        a["psram"] = arena.psram;
+    }
+
+    // Per-task stack and CPU usage
+    JsonArray tasks = doc["tasks"].to<JsonArray>();
+    for (uint8_t i = 0; i < snap.taskCount; i++) {
+        const TaskDiag& t = snap.tasks[i];
+        JsonObject task = tasks.add<JsonObject>();
+        task["name"] = t.name;
+        task["stack_free"] = t.stack_free;
+        if (t.cpu_pct >= 0) {
+            task["cpu_pct"] = serialized(String(t.cpu_pct, 1));
+        }
+    }
+    doc["imu_stack_free"] = snap.imu_stack_free;
+    doc["loop_stack_free"] = snap.loop_stack_free;
+
+    // Telemetry pipeline latency, cumulative since boot
+    JsonObject lat = doc["latency"].to<JsonObject>();
+    for (int i = 0; i < LAT_STAGE_COUNT; i++) {
+        const LatencyHistogram& hist = snap.latency[i];
+        JsonObject stage = lat[LATENCY_STAGE_NAMES[i]].to<JsonObject>();
+        stage["n"] = hist.count;
+        stage["p50_ms"] = serialized(String(diagLatencyPercentile(hist, 0.50f) / 1000.0f, 1));
+        stage["p90_ms"] = serialized(String(diagLatencyPercentile(hist, 0.90f) / 1000.0f, 1));
+        stage["p99_ms"] = serialized(String(diagLatencyPercentile(hist, 0.99f) / 1000.0f, 1));
+        stage["max_ms"] = serialized(String(hist.max_us / 1000.0f, 1));
+
+        JsonArray buckets = stage["buckets"].to<JsonArray>();
+        for (int b = 0; b < LATENCY_BUCKETS; b++) {
+            buckets.add(hist.buckets[b]);
+        }
+    }
+
+    // Module sections
+    for (uint8_t i = 0; i < sectionCount; i++) {
+        sections[i].writer(doc[sections[i].name]);
+    }
+
+    // Cost of the instrumentation itself
+    JsonObject self = doc["self"].to<JsonObject>();
+    self["sample_us"] = snap.sample_cost_us;
+    self["self_us"] = snap.self_us;
+    self["overhead_pct"] = serialized(String(snap.overhead_pct, 3));
+
+    String payload;
+    serializeJson(doc, payload);
+    return payload;
+}
+
+bool diagPublish() {
+    int64_t startUs = esp_timer_get_time();
+    DiagnosticsSnapshot snap;
+
+    if (!diagGetSnapshot(snap)) {
+        Serial.println("No diagnostics snapshot available");
+        return false;
+    }
+
+    String payload = diagBuildPayload(snap, awsGetDeviceId());
+    bool sent = awsPublish(awsGetTopic(AWS_TOPIC_DIAGNOSTICS), payload.c_str()) == AWS_PUBLISH_SENT;
+
+    // Counted in the next snapshot's overhead
+    selfUs += esp_timer_get_time() - startUs;
+    return sent;
+}
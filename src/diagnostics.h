@@ -0,0 +1,111 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Maximum number of FreeRTOS tasks tracked per snapshot
+#define DIAG_MAX_TASKS  24
+
+// Maximum number of module sections in the diagnostics payload
+#define DIAG_MAX_SECTIONS  8
+
+// Latency histogram buckets: bucket i counts values below (64 us << i),
+// so 20 buckets cover 64 us .. 33 s on a log2 scale
+#define LATENCY_BUCKETS     20
+#define LATENCY_BUCKET_US   64
+
+// Telemetry pipeline stages, all measured from the same window
+enum LatencyStage {
+    LAT_WINDOW_TO_SERIALIZE = 0,  // Window closed -> payload build starts
+    LAT_SERIALIZE,                // Payload build time
+    LAT_PUBLISH,                  // awsPublish() call time
+    LAT_WINDOW_TO_ACK,            // Window closed -> publish acknowledged
+    LAT_PUBLISH_TO_ACK,           // Socket write -> PUBACK (QoS 1 only)
+    LAT_STAGE_COUNT
+};
+
+// Cumulative (since boot) latency histogram for one stage
+struct LatencyHistogram {
+    uint32_t buckets[LATENCY_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+};
+
+// Per-task runtime statistics
+struct TaskDiag {
+    char name[16];         // FreeRTOS task name
+    float cpu_pct;         // Share of one core since last sample (-1 if unavailable)
+    uint32_t stack_free;   // Stack high-water mark (bytes never used)
+};
+
+// Firmware self-profiling snapshot
+struct DiagnosticsSnapshot {
+    TaskDiag tasks[DIAG_MAX_TASKS];
+    uint8_t taskCount;
+
+    float core_load_pct[2];        // Busy time per core (100 - idle)
+
+    uint32_t free_heap;            // Free internal heap (bytes)
+    uint32_t min_free_heap;        // Lowest free internal heap since boot
+    uint32_t largest_free_block;   // Largest allocatable internal block
+    float heap_frag_pct;           // 100 * (1 - largest / free)
+    uint32_t free_psram;           // Free PSRAM outside the arenas
+
+    uint32_t imu_stack_free;       // IMU task stack high-water mark
+    uint32_t loop_stack_free;      // loop() task stack high-water mark
+    uint32_t loop_avg_us;          // Mean loop() iteration time
+    uint32_t loop_max_us;          // Worst loop() iteration time
+    uint32_t loop_count;           // Iterations in the sample interval
+
+    LatencyHistogram latency[LAT_STAGE_COUNT];
+
+    uint32_t sample_cost_us;       // Time spent taking this snapshot
+    uint32_t self_us;              // All instrumentation time in the interval: loop timing,
+                                   // latency records, snapshots, building and publishing reports
+    float overhead_pct;            // self_us as a share of one core over the interval
+
+    uint32_t timestamp;            // millis() when sampled
+    bool valid;
+};
+
+// Initialize diagnostics (call from setup(), creates the snapshot mutex)
+void diagInit();
+
+// Bracket one loop() iteration to measure its execution time
+void diagLoopBegin();
+void diagLoopEnd();
+
+// Record one latency measurement for a pipeline stage
+// Call from the loop task only (same task as diagSample)
+void diagRecordLatency(LatencyStage stage, int64_t us);
+
+// Estimate a percentile (0..1) from a histogram, in microseconds
+// Returns the upper bound of the bucket holding that percentile
+uint32_t diagLatencyPercentile(const LatencyHistogram& hist, float pct);
+
+// Writes one module's section of the diagnostics payload into the
+// variant it is given (section.to<JsonObject>() or .to<JsonArray>())
+typedef void (*DiagSectionWriter)(JsonVariant section);
+
+// Add a module's section to every diagnostics payload under name (call
+// from the module's init; sections appear in registration order, and
+// registering the same writer again does nothing)
+// Returns false if DIAG_MAX_SECTIONS are already registered
+bool diagRegisterSection(const char* name, DiagSectionWriter writer);
+
+// Take a new snapshot (call every DIAG_SAMPLE_INTERVAL_MS from main loop)
+void diagSample();
+
+// Get the latest snapshot
+// Returns true if a valid snapshot is available
+bool diagGetSnapshot(DiagnosticsSnapshot& snap);
+
+// Build JSON diagnostics payload
+String diagBuildPayload(const DiagnosticsSnapshot& snap, const char* deviceId);
+
+// Publish latest snapshot to AWS IoT
+// Returns true if published successfully
+bool diagPublish();
+
+#endif // DIAGNOSTICS_H
@@ -1,24 +1,116 @@
 #include "display_ui.h"
 #include "config.h"
+#include "mem_arena.h"
 #include "aws_iot.h"
+#include "diagnostics.h"
 #include <M5Unified.h>
 #include <WiFi.h>
+#include <esp_timer.h>
 
-// Display state
+// Status handed over by loop() (guarded by displayMutex)
+struct PendingState {
+    bool wifiConnected;
+    bool awsConnected;
+    float batteryV;
+    VibrationMetrics metrics;
+    DisplayScreen screen;
+    bool fullRedraw;
+    bool powerOn;
+    char error[32];
+};
+static PendingState pending = {};
+static SemaphoreHandle_t displayMutex = nullptr;
+static TaskHandle_t displayTaskHandle = nullptr;
+
+// Display task's copy of the state for the frame being drawn
 static bool wifiConnected = false;
 static bool awsConnected = false;
-static VibrationMetrics currentMetrics = {0, 0, 0, 0, false};
+static float batteryV = 0;
+static VibrationMetrics currentMetrics = {};
+static char errorMessage[32] = "";
 static uint32_t lastPublishTime = 0;
 static uint32_t publishCount = 0;
+static DisplayScreen currentScreen = SCREEN_GAUGE;
+
+// Off-screen frame (PSRAM) and a copy of what the panel currently shows.
+// Everything is drawn into the frame, then only tiles that differ from
+// the copy are pushed. Without PSRAM, draw straight to the panel.
+static LGFX_Sprite frame(&M5.Lcd);
+static uint16_t* shownFrame = nullptr;
+static LovyanGFX* canvas = &M5.Lcd;
+static bool buffered = false;
+static bool panelStale = true;
+
+// Frame statistics: accumulated by the task, published once per second
+struct FrameAccumulator {
+    uint32_t frames;
+    uint64_t render_us;
+    uint64_t push_us;
+    uint32_t max_us;
+    uint64_t spi_bytes;
+    int64_t start_us;
+};
+static FrameAccumulator acc = {};
+static DisplayStats stats = {};
 
 // Sprite for needle (Lovyan technique - small sprite, rotate it!)
 static LGFX_Sprite needle(&M5.Lcd);
+static uint16_t needleSpriteColor = TFT_WHITE;
+
+// Gauge face (title, arcs, ticks, labels) rasterized once, in PSRAM.
+// Erasing the needle or value restores these pixels instead of redrawing.
+static LGFX_Sprite faceCache(&M5.Lcd);
+static bool faceCached = false;
 
 // Gauge parameters
 static const int GAUGE_CENTER_X = 160;
 static const int GAUGE_CENTER_Y = 150;
 static const int GAUGE_RADIUS = 90;
-static float lastAngle = 180.0f;  // Track last needle position
+static const int NEEDLE_LENGTH = GAUGE_RADIUS - 25;
+
+// Needle resolution: 180 steps over the 0..3 g scale (1 degree each)
+#define NEEDLE_STEPS  180
+
+// Screen rectangle
+struct DisplayRect {
+    int16_t x, y, w, h;
+};
+
+// Needle rotation lookup: screen area covered by the needle and hub at each step
+static DisplayRect needleBoxes[NEEDLE_STEPS + 1];
+
+// Value readout below the hub
+static const DisplayRect VALUE_BOX = {GAUGE_CENTER_X - 45, GAUGE_CENTER_Y + 15, 115, 40};
+
+// What the frame currently shows, so unchanged parts are not redrawn
+static int lastNeedleStep = -1;
+static uint16_t lastNeedleColor = 0;
+static char lastValueText[16] = "";
+static int lastStatusKey = -1;
+
+// Trend plot: one column per window, newest at the right edge
+static const int TREND_X = 10;
+static const int TREND_Y = 40;
+static const int TREND_W = 300;
+static const int TREND_H = 150;
+static const float TREND_MAX_G = 3.0f;
+static uint32_t trendSeq = 0;          // Newest window drawn (right edge)
+static uint32_t trendBackfillSeq = 0;  // Next older window still to draw after a full redraw
+static uint32_t trendBackfillEnd = 0;  // Newest window the backfill has to reach
+
+// Spectrum plot: one bar per band, -60 dB (1 mg) .. 0 dB (1 g)
+static const int SPEC_X = 16;
+static const int SPEC_Y = 40;
+static const int SPEC_H = 150;
+static const int SPEC_BAR_W = 8;
+static const int SPEC_BAR_PITCH = 9;
+static const float SPEC_MIN_DB = -60.0f;
+static uint32_t spectrumSeq = 0;
+static int16_t spectrumHeights[SPECTRUM_BANDS];
+
+// Frame start time, for the render budget
+static int64_t frameStartUs = 0;
+static uint32_t overBudgetTotal = 0;
 
 // Colors
 #define COLOR_BG        TFT_BLACK
@@ -29,11 +121,51 @@ static float lastAngle = 180.0f;  // Track last needle position
 #define COLOR_TEXT      TFT_WHITE
 #define COLOR_DIM       TFT_DARKGREY
 
+// Forward declarations
+static void displayTask(void* param);
+static void initNeedleBoxes();
+static void drawGaugeBackground();
+
+// Diagnostics "display" section: display task frame cost
+static void writeDiagSection(JsonVariant section) {
+    DisplayStats dispStats;
+    displayGetStats(dispStats);
+    JsonObject disp = section.to<JsonObject>();
+    disp["fps"] = serialized(String(dispStats.fps, 1));
+    disp["render_us"] = dispStats.render_us;
+    disp["push_us"] = dispStats.push_us;
+    disp["frame_max_us"] = dispStats.frame_max_us;
+    disp["spi_bytes"] = dispStats.spi_bytes;
+    disp["dirty_pct"] = serialized(String(dispStats.dirty_pct, 1));
+    disp["over_budget"] = dispStats.over_budget;
+    disp["buffered"] = dispStats.buffered;
+}
+
 void displayInit() {
+    diagRegisterSection("display", writeDiagSection);
+
     M5.Lcd.fillScreen(COLOR_BG);
     M5.Lcd.setTextColor(COLOR_TEXT, COLOR_BG);
     M5.Lcd.setTextDatum(TL_DATUM);
 
+    // Full-screen 16-bit frame sprite plus the shown-frame copy, both in PSRAM
+    frame.setColorDepth(16);
+    frame.setPsram(true);
+    if (frame.createSprite(M5.Lcd.width(), M5.Lcd.height()) != nullptr) {
+        shownFrame = (uint16_t*)memArenaAlloc(ARENA_DISPLAY, M5.Lcd.width() * M5.Lcd.height() * sizeof(uint16_t));
+        if (shownFrame == nullptr) {
+            frame.deleteSprite();
+        }
+    }
+
+    if (shownFrame != nullptr) {
+        canvas = &frame;
+        buffered = true;
+    } else {
+        Serial.println("WARNING: No PSRAM for frame buffer - drawing directly to the panel");
+    }
+    canvas->setTextDatum(TL_DATUM);
+
     // Create tiny sprite for needle (Lovyan technique!)
     needle.setColorDepth(16);
     needle.createSprite(4, GAUGE_RADIUS - 25);
@@ -43,33 +175,108 @@ void displayInit() {
     needle.fillSprite(TFT_TRANSPARENT);
     needle.fillRect(0, 0, 4, needle.height(), TFT_WHITE);
     needle.fillCircle(2, 0, 3, TFT_WHITE);
+
+    initNeedleBoxes();
+
+    // Rasterize the gauge face once
+    if (buffered) {
+        faceCache.setColorDepth(16);
+        faceCache.setPsram(true);
+        if (faceCache.createSprite(frame.width(), frame.height()) != nullptr) {
+            canvas = &faceCache;
+            canvas->fillScreen(COLOR_BG);
+            drawGaugeBackground();
+            canvas = &frame;
+            faceCached = true;
+        } else {
+            Serial.println("WARNING: No PSRAM for gauge face cache");
+        }
+    }
+
+    displayMutex = xSemaphoreCreateMutex();
+
+    if (displayMutex == nullptr) {
+        Serial.println("ERROR: Failed to create display mutex");
+        return;
+    }
+
+    pending.fullRedraw = true;
+    pending.powerOn = true;
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        displayTask,
+        "display",
+        DISPLAY_TASK_STACK_SIZE,
+        nullptr,
+        DISPLAY_TASK_PRIORITY,
+        &displayTaskHandle,
+        DISPLAY_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        Serial.println("ERROR: Failed to create display task");
+        return;
+    }
+
+    Serial.printf("Display task started: %d ms frames, %s\n", DISPLAY_FRAME_INTERVAL_MS,
+                  buffered ? "PSRAM frame buffer" : "direct drawing");
+}
+
+// Run fn on the pending state with the display mutex held
+template <typename Fn>
+static void withPending(Fn fn) {
+    if (displayMutex == nullptr) {
+        return;
+    }
+
+    if (xSemaphoreTake(displayMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        fn(pending);
+        xSemaphoreGive(displayMutex);
+    }
 }
 
 void displaySetWiFiStatus(bool connected) {
-    wifiConnected = connected;
+    withPending([&](PendingState& p) { p.wifiConnected = connected; });
 }
 
 void displaySetAWSStatus(bool connected) {
-    awsConnected = connected;
+    withPending([&](PendingState& p) { p.awsConnected = connected; });
 }
 
 void displaySetMetrics(const VibrationMetrics& metrics) {
-    currentMetrics = metrics;
+    withPending([&](PendingState& p) { p.metrics = metrics; });
+}
+
+void displayShowError(const char* message) {
+    withPending([&](PendingState& p) { strlcpy(p.error, message, sizeof(p.error)); });
+}
+
+void displaySetPower(bool on) {
+    withPending([&](PendingState& p) { p.powerOn = on; });
+
+    if (on && displayTaskHandle != nullptr) {
+        xTaskNotifyGive(displayTaskHandle);
+    }
+}
+
+void displayGetStats(DisplayStats& out) {
+    out = {};
+    withPending([&](PendingState&) { out = stats; });
 }
 
 static void drawStatusBar() {
     // Simple status indicators at bottom
-    M5.Lcd.setFont(&fonts::FreeSans9pt7b);
+    canvas->setFont(&fonts::FreeSans9pt7b);
 
     // WiFi indicator
-    M5.Lcd.fillCircle(20, 225, 6, wifiConnected ? COLOR_OK : COLOR_ERROR);
-    M5.Lcd.setTextColor(COLOR_DIM, COLOR_BG);
-    M5.Lcd.drawString("WiFi", 30, 220);
+    canvas->fillCircle(20, 225, 6, wifiConnected ? COLOR_OK : COLOR_ERROR);
+    canvas->setTextColor(COLOR_DIM, COLOR_BG);
+    canvas->drawString("WiFi", 30, 220);
 
     // AWS indicator - moved 80 pixels right
-    M5.Lcd.fillCircle(130, 225, 6, awsConnected ? COLOR_OK : COLOR_ERROR);
-    M5.Lcd.setTextColor(COLOR_DIM, COLOR_BG);
-    M5.Lcd.drawString("AWS", 140, 220);
+    canvas->fillCircle(130, 225, 6, awsConnected ? COLOR_OK : COLOR_ERROR);
+    canvas->setTextColor(COLOR_DIM, COLOR_BG);
+    canvas->drawString("AWS", 140, 220);
 }
 
 static uint16_t getRMSColor(float rms) {
@@ -91,17 +298,17 @@ static void drawGaugeBackground() {
     const float maxG = 3.0f;
 
     // Title at very top, centered
-    M5.Lcd.setFont(&fonts::FreeSansBold12pt7b);
-    M5.Lcd.setTextColor(COLOR_HEADER, COLOR_BG);
-    M5.Lcd.setTextDatum(TC_DATUM);
-    M5.Lcd.drawString("VIBRATION RMS", 160, 5);
-    M5.Lcd.setTextDatum(TL_DATUM);
+    canvas->setFont(&fonts::FreeSansBold12pt7b);
+    canvas->setTextColor(COLOR_HEADER, COLOR_BG);
+    canvas->setTextDatum(TC_DATUM);
+    canvas->drawString("VIBRATION RMS", 160, 5);
+    canvas->setTextDatum(TL_DATUM);
 
     // Draw thick gauge background arcs
     for (int i = 0; i < 15; i++) {
-        M5.Lcd.drawArc(GAUGE_CENTER_X, GAUGE_CENTER_Y, GAUGE_RADIUS-i, GAUGE_RADIUS-i-1, 180, 240, COLOR_OK);
-        M5.Lcd.drawArc(GAUGE_CENTER_X, GAUGE_CENTER_Y, GAUGE_RADIUS-i, GAUGE_RADIUS-i-1, 240, 300, COLOR_WARN);
-        M5.Lcd.drawArc(GAUGE_CENTER_X, GAUGE_CENTER_Y, GAUGE_RADIUS-i, GAUGE_RADIUS-i-1, 300, 360, COLOR_ERROR);
+        canvas->drawArc(GAUGE_CENTER_X, GAUGE_CENTER_Y, GAUGE_RADIUS-i, GAUGE_RADIUS-i-1, 180, 240, COLOR_OK);
+        canvas->drawArc(GAUGE_CENTER_X, GAUGE_CENTER_Y, GAUGE_RADIUS-i, GAUGE_RADIUS-i-1, 240, 300, COLOR_WARN);
+        canvas->drawArc(GAUGE_CENTER_X, GAUGE_CENTER_Y, GAUGE_RADIUS-i, GAUGE_RADIUS-i-1, 300, 360, COLOR_ERROR);
     }
 
     // Draw scale markings
@@ -112,96 +319,621 @@ static void drawGaugeBackground() {
         int y1 = GAUGE_CENTER_Y + (GAUGE_RADIUS - 16) * sin(rad);
         int x2 = GAUGE_CENTER_X + (GAUGE_RADIUS - 25) * cos(rad);
         int y2 = GAUGE_CENTER_Y + (GAUGE_RADIUS - 25) * sin(rad);
-        M5.Lcd.drawLine(x1, y1, x2, y2, TFT_WHITE);
+        canvas->drawLine(x1, y1, x2, y2, TFT_WHITE);
     }
 
     // Draw scale numbers (adjusted positions)
-    M5.Lcd.setFont(&fonts::FreeSansBold12pt7b);
-    M5.Lcd.setTextColor(COLOR_TEXT, COLOR_BG);
-    M5.Lcd.drawString("0", GAUGE_CENTER_X - 95, GAUGE_CENTER_Y + 10);
-    M5.Lcd.drawString("1", GAUGE_CENTER_X - 80, GAUGE_CENTER_Y - 50);  // Adjusted: left 5px, down 5px
-    M5.Lcd.drawString("2", GAUGE_CENTER_X - 8, GAUGE_CENTER_Y - 90);   // Moved up 10px
-    M5.Lcd.drawString("3", GAUGE_CENTER_X + 65, GAUGE_CENTER_Y - 55);
+    canvas->setFont(&fonts::FreeSansBold12pt7b);
+    canvas->setTextColor(COLOR_TEXT, COLOR_BG);
+    canvas->drawString("0", GAUGE_CENTER_X - 95, GAUGE_CENTER_Y + 10);
+    canvas->drawString("1", GAUGE_CENTER_X - 80, GAUGE_CENTER_Y - 50);  // Adjusted: left 5px, down 5px
+    canvas->drawString("2", GAUGE_CENTER_X - 8, GAUGE_CENTER_Y - 90);   // Moved up 10px
+    canvas->drawString("3", GAUGE_CENTER_X + 65, GAUGE_CENTER_Y - 55);
 }
 
-static void drawVibrationGauge() {
-    const float maxG = 3.0f;
+static float needleAngle(int step) {
+    return 180 + step * 180.0f / NEEDLE_STEPS;  // 180° to 360°
+}
+
+static void initNeedleBoxes() {
+    // Needle half-width, tip circle and hub radius
+    const int margin = 8;
+
+    for (int i = 0; i <= NEEDLE_STEPS; i++) {
+        // pushRotated(angle + 60) points the needle at gauge angle - 30°
+        float rad = (needleAngle(i) - 30) * PI / 180.0;
+        int tipX = GAUGE_CENTER_X + lroundf((NEEDLE_LENGTH + 3) * cosf(rad));
+        int tipY = GAUGE_CENTER_Y + lroundf((NEEDLE_LENGTH + 3) * sinf(rad));
+
+        int x0 = min(GAUGE_CENTER_X, tipX) - margin;
+        int y0 = min(GAUGE_CENTER_Y, tipY) - margin;
+        int x1 = max(GAUGE_CENTER_X, tipX) + margin;
+        int y1 = max(GAUGE_CENTER_Y, tipY) + margin;
+        needleBoxes[i] = {(int16_t)x0, (int16_t)y0, (int16_t)(x1 - x0 + 1), (int16_t)(y1 - y0 + 1)};
+    }
+}
 
-    // Erase old needle area - clear full needle length (65px) + tip radius
-    M5.Lcd.fillCircle(GAUGE_CENTER_X, GAUGE_CENTER_Y, 70, COLOR_BG);
+// Copy cached gauge-face pixels over a rectangle of the frame
+static void restoreFace(const DisplayRect& r) {
+    const int w = frame.width();
+    const int h = frame.height();
+    int x0 = max<int>(r.x, 0);
+    int y0 = max<int>(r.y, 0);
+    int x1 = min<int>(r.x + r.w, w);
+    int y1 = min<int>(r.y + r.h, h);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    const uint16_t* src = (const uint16_t*)faceCache.getBuffer();
+    uint16_t* dst = (uint16_t*)frame.getBuffer();
+    for (int y = y0; y < y1; y++) {
+        memcpy(dst + y * w + x0, src + y * w + x0, (x1 - x0) * sizeof(uint16_t));
+    }
+}
+
+static void drawVibrationGauge(bool full) {
+    const float maxG = 3.0f;
+    char text[16];
+    int step = -1;
+    uint16_t needleColor = COLOR_DIM;
 
     if (currentMetrics.valid) {
         float rms = constrain(currentMetrics.rms_g, 0, maxG);
-        float angle = 180 + (rms / maxG) * 180;  // 180° to 360°
+        step = lroundf((rms / maxG) * NEEDLE_STEPS);
+        needleColor = getRMSColor(rms);
+        snprintf(text, sizeof(text), "%.2f", currentMetrics.rms_g);
+    } else {
+        strlcpy(text, "--", sizeof(text));
+    }
+
+    // Nothing to do unless the needle moved a step or the readout changed
+    if (!full && step == lastNeedleStep && needleColor == lastNeedleColor &&
+        strcmp(text, lastValueText) == 0) {
+        return;
+    }
 
-        uint16_t needleColor = getRMSColor(rms);
+    // Erase the old needle and readout (the needle can dip into the readout
+    // near 0 g, so both are redrawn together)
+    if (faceCached) {
+        if (lastNeedleStep >= 0) {
+            restoreFace(needleBoxes[lastNeedleStep]);
+        }
+        restoreFace(VALUE_BOX);
+    } else {
+        // Clear full needle length (65px) + tip radius
+        canvas->fillCircle(GAUGE_CENTER_X, GAUGE_CENTER_Y, 70, COLOR_BG);
+    }
 
+    if (step >= 0) {
         // Set pivot and draw rotated needle (Lovyan technique!)
-        M5.Lcd.setPivot(GAUGE_CENTER_X, GAUGE_CENTER_Y);
-        needle.setPaletteColor(1, needleColor);
+        canvas->setPivot(GAUGE_CENTER_X, GAUGE_CENTER_Y);
+        // The sprite is 16-bit (no palette), so recolour its pixels when the colour changes
+        if (needleColor != needleSpriteColor) {
+            needle.fillRect(0, 0, 4, needle.height(), needleColor);
+            needle.fillCircle(2, 0, 3, needleColor);
+            needleSpriteColor = needleColor;
+        }
         // Fine-tuned: +90° for sprite alignment, -30° to point at correct value
-        needle.pushRotated(angle + 60);
-
-        lastAngle = angle;
+        needle.pushRotated(canvas, needleAngle(step) + 60);
 
         // Center hub
-        M5.Lcd.fillCircle(GAUGE_CENTER_X, GAUGE_CENTER_Y, 6, needleColor);
+        canvas->fillCircle(GAUGE_CENTER_X, GAUGE_CENTER_Y, 6, needleColor);
 
         // Value in center
-        char buf[16];
-        snprintf(buf, sizeof(buf), "%.2f", currentMetrics.rms_g);
-        M5.Lcd.setFont(&fonts::FreeSansBold18pt7b);
-        M5.Lcd.setTextColor(needleColor, COLOR_BG);
-        M5.Lcd.drawString(buf, GAUGE_CENTER_X - 40, GAUGE_CENTER_Y + 20);
-
-        M5.Lcd.setFont(&fonts::FreeSansBold12pt7b);
-        M5.Lcd.setTextColor(COLOR_DIM, COLOR_BG);
-        M5.Lcd.drawString("g", GAUGE_CENTER_X + 35, GAUGE_CENTER_Y + 30);
+        canvas->setFont(&fonts::FreeSansBold18pt7b);
+        canvas->setTextColor(needleColor, COLOR_BG);
+        canvas->drawString(text, GAUGE_CENTER_X - 40, GAUGE_CENTER_Y + 20);
+
+        canvas->setFont(&fonts::FreeSansBold12pt7b);
+        canvas->setTextColor(COLOR_DIM, COLOR_BG);
+        canvas->drawString("g", GAUGE_CENTER_X + 35, GAUGE_CENTER_Y + 30);
     } else {
-        M5.Lcd.setFont(&fonts::FreeSansBold18pt7b);
-        M5.Lcd.setTextColor(COLOR_DIM, COLOR_BG);
-        M5.Lcd.drawString("--", GAUGE_CENTER_X - 25, GAUGE_CENTER_Y + 20);
+        canvas->setFont(&fonts::FreeSansBold18pt7b);
+        canvas->setTextColor(COLOR_DIM, COLOR_BG);
+        canvas->drawString(text, GAUGE_CENTER_X - 25, GAUGE_CENTER_Y + 20);
     }
+
+    lastNeedleStep = step;
+    lastNeedleColor = needleColor;
+    strlcpy(lastValueText, text, sizeof(lastValueText));
 }
 
-static void drawVibrationMetrics() {
-    drawVibrationGauge();
+static void drawVibrationMetrics(bool full) {
+    drawVibrationGauge(full);
 }
 
 static void drawDeviceInfo() {
     // Keep it minimal - just battery
     char buf[16];
-    M5.Lcd.setFont(&fonts::FreeSans9pt7b);
-    M5.Lcd.setTextColor(COLOR_DIM, COLOR_BG);
+    canvas->setFont(&fonts::FreeSans9pt7b);
+    canvas->setTextColor(COLOR_DIM, COLOR_BG);
 
-    float batteryV = M5.Power.getBatteryVoltage() / 1000.0f;
     snprintf(buf, sizeof(buf), "%.1fV", batteryV);
-    M5.Lcd.drawString(buf, 270, 220);
+    canvas->drawString(buf, 270, 220);
 }
 
-void displayDrawStatusScreen() {
-    // Draw static gauge background once
-    drawGaugeBackground();
+static void drawDiagnosticsBackground() {
+    canvas->setFont(&fonts::FreeSansBold12pt7b);
+    canvas->setTextColor(COLOR_HEADER, COLOR_BG);
+    canvas->setTextDatum(TC_DATUM);
+    canvas->drawString("DIAGNOSTICS", 160, 5);
+    canvas->setTextDatum(TL_DATUM);
+}
+
+static void drawDiagLine(int row, uint16_t color, const char* text) {
+    // Fixed-width bitmap font with background color overwrites the old line
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%-38s", text);
+    canvas->setFont(&fonts::Font2);
+    canvas->setTextColor(color, COLOR_BG);
+    canvas->drawString(buf, 8, 36 + row * 17);
+}
+
+static void drawDiagnostics() {
+    DiagnosticsSnapshot snap;
+    char buf[48];
+
+    if (!diagGetSnapshot(snap)) {
+        drawDiagLine(0, COLOR_DIM, "Waiting for first snapshot...");
+        return;
+    }
+
+    if (snap.core_load_pct[0] >= 0) {
+        snprintf(buf, sizeof(buf), "CPU  core0 %5.1f%%  core1 %5.1f%%",
+                 snap.core_load_pct[0], snap.core_load_pct[1]);
+        drawDiagLine(0, COLOR_TEXT, buf);
+    } else {
+        drawDiagLine(0, COLOR_DIM, "CPU  run-time stats unavailable");
+    }
 
-    // Draw dynamic parts
-    drawVibrationMetrics();
-    drawStatusBar();
-    drawDeviceInfo();
+    snprintf(buf, sizeof(buf), "Loop avg %lu us  max %lu us",
+             (unsigned long)snap.loop_avg_us, (unsigned long)snap.loop_max_us);
+    drawDiagLine(1, COLOR_TEXT, buf);
+
+    snprintf(buf, sizeof(buf), "Heap free %lu  block %lu",
+             (unsigned long)snap.free_heap, (unsigned long)snap.largest_free_block);
+    drawDiagLine(2, COLOR_TEXT, buf);
+
+    snprintf(buf, sizeof(buf), "Frag %.1f%%  min free %lu",
+             snap.heap_frag_pct, (unsigned long)snap.min_free_heap);
+    drawDiagLine(3, snap.heap_frag_pct < 50.0f ? COLOR_TEXT : COLOR_WARN, buf);
+
+    // Warn when less than a quarter of the IMU stack has never been touched
+    snprintf(buf, sizeof(buf), "IMU stack free %lu / %d",
+             (unsigned long)snap.imu_stack_free, IMU_TASK_STACK_SIZE);
+    drawDiagLine(4, snap.imu_stack_free > IMU_TASK_STACK_SIZE / 4 ? COLOR_OK : COLOR_ERROR, buf);
+
+    // Busiest tasks first
+    int shown = 0;
+    bool used[DIAG_MAX_TASKS] = {false};
+    while (shown < 4 && shown < snap.taskCount) {
+        int best = -1;
+        for (int i = 0; i < snap.taskCount; i++) {
+            if (!used[i] && (best < 0 || snap.tasks[i].cpu_pct > snap.tasks[best].cpu_pct)) {
+                best = i;
+            }
+        }
+        used[best] = true;
+
+        const TaskDiag& t = snap.tasks[best];
+        if (t.cpu_pct >= 0) {
+            snprintf(buf, sizeof(buf), "%-12s %5.1f%%  stack %lu", t.name, t.cpu_pct, (unsigned long)t.stack_free);
+        } else {
+            snprintf(buf, sizeof(buf), "%-12s stack %lu", t.name, (unsigned long)t.stack_free);
+        }
+        drawDiagLine(5 + shown, COLOR_DIM, buf);
+        shown++;
+    }
+
+    const LatencyHistogram& e2e = snap.latency[LAT_WINDOW_TO_ACK];
+    snprintf(buf, sizeof(buf), "Window->ack p50 %.0f  p99 %.0f ms",
+             diagLatencyPercentile(e2e, 0.50f) / 1000.0f, diagLatencyPercentile(e2e, 0.99f) / 1000.0f);
+    drawDiagLine(9, COLOR_TEXT, buf);
+
+    snprintf(buf, sizeof(buf), "Profiling overhead %.3f%% (%lu us)",
+             snap.overhead_pct, (unsigned long)snap.self_us);
+    drawDiagLine(10, snap.overhead_pct < 1.0f ? COLOR_OK : COLOR_ERROR, buf);
+
+    // Written by this task, so no lock needed
+    snprintf(buf, sizeof(buf), "Display %.0f fps  %lu us  %lu B/frame",
+             stats.fps, (unsigned long)(stats.render_us + stats.push_us), (unsigned long)stats.spi_bytes);
+    drawDiagLine(11, stats.buffered ? COLOR_DIM : COLOR_WARN, buf);
+}
+
+static bool overRenderBudget() {
+    return esp_timer_get_time() - frameStartUs > DISPLAY_RENDER_BUDGET_US;
+}
+
+static void drawPlotTitle(const char* title) {
+    canvas->setFont(&fonts::FreeSansBold12pt7b);
+    canvas->setTextColor(COLOR_HEADER, COLOR_BG);
+    canvas->setTextDatum(TC_DATUM);
+    canvas->drawString(title, 160, 5);
+    canvas->setTextDatum(TL_DATUM);
+}
+
+static int trendY(float g) {
+    float clamped = constrain(g, 0.0f, TREND_MAX_G);
+    return TREND_Y + TREND_H - 1 - lroundf(clamped / TREND_MAX_G * (TREND_H - 1));
+}
+
+// Draw one window as a column: RMS as a bar, peak as a dot, over the 1 g / 2 g grid
+static void drawTrendColumn(int x, const VibrationMetrics& m) {
+    canvas->drawFastVLine(x, TREND_Y, TREND_H, COLOR_BG);
+    canvas->drawPixel(x, trendY(1.0f), COLOR_DIM);
+    canvas->drawPixel(x, trendY(2.0f), COLOR_DIM);
+
+    if (!m.valid) {
+        return;
+    }
+
+    int rmsY = trendY(m.rms_g);
+    canvas->drawFastVLine(x, rmsY, TREND_Y + TREND_H - rmsY, getRMSColor(m.rms_g));
+    canvas->drawPixel(x, trendY(m.peak_g), getPeakColor(m.peak_g));
+}
+
+static void drawTrendBackground() {
+    char buf[24];
+    snprintf(buf, sizeof(buf), "TREND %d SEC", TREND_W * IMU_HOP_SAMPLES / IMU_SAMPLE_RATE_HZ);
+    drawPlotTitle(buf);
+
+    canvas->drawFastHLine(TREND_X, trendY(1.0f), TREND_W, COLOR_DIM);
+    canvas->drawFastHLine(TREND_X, trendY(2.0f), TREND_W, COLOR_DIM);
+    canvas->drawFastHLine(TREND_X, TREND_Y + TREND_H, TREND_W, COLOR_DIM);
+
+    // Draw the visible history over the next frames, within the render budget
+    trendSeq = imuGetLatestSeq();
+    trendBackfillEnd = trendSeq;
+    trendBackfillSeq = trendSeq > (uint32_t)TREND_W ? trendSeq - TREND_W + 1 : 1;
+}
+
+static void drawTrend() {
+    VibrationMetrics windows[8];
+    char buf[48];
+
+    // New windows: shift the plot left and draw only the new column
+    size_t n = imuGetHistory(trendSeq, windows, 8);
+    for (size_t i = 0; i < n; i++) {
+        uint32_t shift = windows[i].seq - trendSeq;
+        canvas->setScrollRect(TREND_X, TREND_Y, TREND_W, TREND_H);
+        canvas->scroll(-(int32_t)min<uint32_t>(shift, TREND_W), 0);
+        canvas->clearScrollRect();
+
+        trendSeq = windows[i].seq;
+        drawTrendColumn(TREND_X + TREND_W - 1, windows[i]);
+    }
+
+    if (n > 0) {
+        const VibrationMetrics& m = windows[n - 1];
+        snprintf(buf, sizeof(buf), "RMS %.2f g   peak %.2f g", m.rms_g, m.peak_g);
+        drawDiagLine(10, COLOR_TEXT, buf);
+    }
+
+    // Backfill older columns after a full redraw
+    while (trendBackfillSeq <= trendBackfillEnd && !overRenderBudget()) {
+        n = imuGetHistory(trendBackfillSeq - 1, windows, 8);
+        if (n == 0) {
+            trendBackfillSeq = trendBackfillEnd + 1;
+            break;
+        }
+
+        for (size_t i = 0; i < n && windows[i].seq <= trendBackfillEnd; i++) {
+            int x = TREND_X + TREND_W - 1 - (int)(trendSeq - windows[i].seq);
+            if (x >= TREND_X) {
+                drawTrendColumn(x, windows[i]);
+            }
+            trendBackfillSeq = windows[i].seq + 1;
+        }
+
+        if (windows[n - 1].seq > trendBackfillEnd) {
+            trendBackfillSeq = trendBackfillEnd + 1;
+        }
+    }
+}
+
+static int spectrumHeight(float g) {
+    float db = g > 0 ? 20.0f * log10f(g) : SPEC_MIN_DB;
+    float frac = constrain((db - SPEC_MIN_DB) / -SPEC_MIN_DB, 0.0f, 1.0f);
+    return lroundf(frac * SPEC_H);
+}
+
+static void drawSpectrumBackground() {
+    drawPlotTitle("SPECTRUM");
+
+    canvas->drawFastHLine(SPEC_X, SPEC_Y + SPEC_H, SPECTRUM_BANDS * SPEC_BAR_PITCH, COLOR_DIM);
+
+    canvas->setFont(&fonts::Font2);
+    canvas->setTextColor(COLOR_DIM, COLOR_BG);
+    canvas->drawString("0", SPEC_X, SPEC_Y + SPEC_H + 3);
+    canvas->setTextDatum(TC_DATUM);
+    canvas->drawString("125", SPEC_X + SPECTRUM_BANDS * SPEC_BAR_PITCH / 2, SPEC_Y + SPEC_H + 3);
+    canvas->setTextDatum(TR_DATUM);
+    canvas->drawString("250 Hz", SPEC_X + SPECTRUM_BANDS * SPEC_BAR_PITCH, SPEC_Y + SPEC_H + 3);
+    canvas->drawString("-60..0 dBg", SPEC_X + SPECTRUM_BANDS * SPEC_BAR_PITCH, SPEC_Y - 8);
+    canvas->setTextDatum(TL_DATUM);
+
+    spectrumSeq = 0;
+    memset(spectrumHeights, 0, sizeof(spectrumHeights));
+}
+
+static void drawSpectrum() {
+    VibrationSpectrum spectrum;
+    char buf[48];
+
+    if (!imuGetLatestSpectrum(spectrum) || spectrum.seq == spectrumSeq) {
+        return;
+    }
+    spectrumSeq = spectrum.seq;
+
+    // Grow or shrink each bar by the difference only
+    const int base = SPEC_Y + SPEC_H;
+    int peakBand = 0;
+    for (int b = 0; b < SPECTRUM_BANDS; b++) {
+        int x = SPEC_X + b * SPEC_BAR_PITCH;
+        int h = spectrumHeight(spectrum.bands_g[b]);
+        int old = spectrumHeights[b];
+
+        if (h > old) {
+            canvas->fillRect(x, base - h, SPEC_BAR_W, h - old, COLOR_HEADER);
+        } else if (h < old) {
+            canvas->fillRect(x, base - old, SPEC_BAR_W, old - h, COLOR_BG);
+        }
+        spectrumHeights[b] = h;
+
+        if (spectrum.bands_g[b] > spectrum.bands_g[peakBand]) {
+            peakBand = b;
+        }
+    }
+
+    snprintf(buf, sizeof(buf), "Peak %.0f Hz  %.3f g",
+             (peakBand + 0.5f) * spectrum.band_hz, spectrum.bands_g[peakBand]);
+    drawDiagLine(11, COLOR_TEXT, buf);
+}
+
+void displaySetScreen(DisplayScreen screen) {
+    withPending([&](PendingState& p) {
+        p.screen = screen;
+        p.fullRedraw = true;
+    });
+}
+
+void displayNextScreen() {
+    DisplayScreen next = SCREEN_GAUGE;
+    withPending([&](PendingState& p) { next = (DisplayScreen)((p.screen + 1) % SCREEN_COUNT); });
+    displaySetScreen(next);
+}
+
+void displayDrawStatusScreen() {
+    withPending([&](PendingState& p) { p.fullRedraw = true; });
 }
 
 void displayUpdate() {
-    // Update connection status
-    displaySetWiFiStatus(WiFi.status() == WL_CONNECTED);
-    displaySetAWSStatus(awsIsConnected());
+    // Gather status here so the display task never touches WiFi, MQTT or I2C
+    bool wifi = WiFi.status() == WL_CONNECTED;
+    bool aws = awsIsConnected();
+    float battery = M5.Power.getBatteryVoltage() / 1000.0f;
+
+    withPending([&](PendingState& p) {
+        p.wifiConnected = wifi;
+        p.awsConnected = aws;
+        p.batteryV = battery;
+    });
+}
 
-    // Get latest metrics
+// Copy the pending state for this frame; returns true if a full redraw is needed
+static bool takePendingState() {
+    bool full = false;
+
+    withPending([&](PendingState& p) {
+        wifiConnected = p.wifiConnected;
+        awsConnected = p.awsConnected;
+        batteryV = p.batteryV;
+        if (p.metrics.valid) {
+            currentMetrics = p.metrics;
+        }
+        strlcpy(errorMessage, p.error, sizeof(errorMessage));
+        full = p.fullRedraw || p.screen != currentScreen;
+        currentScreen = p.screen;
+        p.fullRedraw = false;
+    });
+
+    // Pick up each new window as soon as it is computed
     VibrationMetrics metrics;
     if (imuGetLatestMetrics(metrics)) {
-        displaySetMetrics(metrics);
+        currentMetrics = metrics;
+    }
+
+    return full;
+}
+
+static void renderFrame(bool full) {
+    if (full) {
+        if (currentScreen == SCREEN_DIAGNOSTICS) {
+            canvas->fillScreen(COLOR_BG);
+            drawDiagnosticsBackground();
+        } else if (currentScreen == SCREEN_TREND) {
+            canvas->fillScreen(COLOR_BG);
+            drawTrendBackground();
+        } else if (currentScreen == SCREEN_SPECTRUM) {
+            canvas->fillScreen(COLOR_BG);
+            drawSpectrumBackground();
+        } else if (faceCached) {
+            faceCache.pushSprite(&frame, 0, 0);
+        } else {
+            canvas->fillScreen(COLOR_BG);
+            drawGaugeBackground();
+        }
+        lastNeedleStep = -1;
+    }
+
+    if (currentScreen == SCREEN_DIAGNOSTICS) {
+        drawDiagnostics();
+    } else if (currentScreen == SCREEN_TREND) {
+        drawTrend();
+    } else if (currentScreen == SCREEN_SPECTRUM) {
+        drawSpectrum();
+    } else {
+        drawVibrationMetrics(full);
+
+        // Status bar only changes with the links or the 0.1 V battery reading
+        int statusKey = (wifiConnected ? 1 : 0) | (awsConnected ? 2 : 0) | (lroundf(batteryV * 10) << 2);
+        if (full || statusKey != lastStatusKey) {
+            drawStatusBar();
+            drawDeviceInfo();
+            lastStatusKey = statusKey;
+        }
     }
 
-    // Redraw only dynamic parts (needle rotates via pushRotated)
-    drawVibrationMetrics();
-    drawStatusBar();
-    drawDeviceInfo();
+    if (errorMessage[0] != '\0') {
+        canvas->setFont(&fonts::FreeSansBold12pt7b);
+        canvas->setTextColor(COLOR_ERROR, COLOR_BG);
+        canvas->drawString(errorMessage, 10, 100);
+    }
+}
+
+// Copy a tile into the shown-frame copy if it changed; returns true if it did
+static bool syncTile(const uint16_t* cur, int x, int y, int w, int h) {
+    const int stride = frame.width();
+    bool changed = panelStale;
+
+    for (int row = y; row < y + h; row++) {
+        size_t off = (size_t)row * stride + x;
+        if (changed || memcmp(cur + off, shownFrame + off, w * sizeof(uint16_t)) != 0) {
+            memcpy(shownFrame + off, cur + off, w * sizeof(uint16_t));
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+// Queue one rectangle of the frame to the panel. The clip rect selects the
+// region; LovyanGFX streams it via DMA, bouncing PSRAM through its own
+// DMA-capable buffers, and returns while the transfer is still running.
+static void pushRegion(int x, int y, int w, int h) {
+    M5.Lcd.setClipRect(x, y, w, h);
+    M5.Lcd.pushImageDMA(0, 0, frame.width(), frame.height(), (const lgfx::swap565_t*)frame.getBuffer());
+    M5.Lcd.clearClipRect();
+}
+
+// Push runs of changed tiles, one tile row at a time
+// Returns the number of pixel bytes sent
+static uint32_t pushDirtyTiles() {
+    const int w = frame.width();
+    const int h = frame.height();
+    const uint16_t* cur = (const uint16_t*)frame.getBuffer();
+    uint32_t bytes = 0;
+
+    M5.Lcd.startWrite();
+    for (int ty = 0; ty < h; ty += DISPLAY_TILE_H) {
+        int th = min(DISPLAY_TILE_H, h - ty);
+        int runStart = -1;
+
+        for (int tx = 0; tx < w; tx += DISPLAY_TILE_W) {
+            int tw = min(DISPLAY_TILE_W, w - tx);
+
+            if (syncTile(cur, tx, ty, tw, th)) {
+                if (runStart < 0) {
+                    runStart = tx;
+                }
+            } else if (runStart >= 0) {
+                pushRegion(runStart, ty, tx - runStart, th);
+                bytes += (tx - runStart) * th * sizeof(uint16_t);
+                runStart = -1;
+            }
+        }
+
+        if (runStart >= 0) {
+            pushRegion(runStart, ty, w - runStart, th);
+            bytes += (w - runStart) * th * sizeof(uint16_t);
+        }
+    }
+    M5.Lcd.endWrite();
+
+    panelStale = false;
+    return bytes;
+}
+
+static void recordFrame(uint32_t renderUs, uint32_t pushUs, uint32_t bytes) {
+    int64_t now = esp_timer_get_time();
+    if (acc.frames == 0) {
+        acc.start_us = now;
+    }
+
+    if (renderUs > DISPLAY_RENDER_BUDGET_US) {
+        overBudgetTotal++;
+    }
+
+    acc.frames++;
+    acc.render_us += renderUs;
+    acc.push_us += pushUs;
+    acc.spi_bytes += bytes;
+    if (renderUs + pushUs > acc.max_us) {
+        acc.max_us = renderUs + pushUs;
+    }
+
+    int64_t elapsed = now - acc.start_us;
+    if (elapsed < 1000000) {
+        return;
+    }
+
+    DisplayStats next;
+    next.fps = acc.frames * 1e6f / elapsed;
+    next.render_us = acc.render_us / acc.frames;
+    next.push_us = acc.push_us / acc.frames;
+    next.frame_max_us = acc.max_us;
+    next.spi_bytes = acc.spi_bytes / acc.frames;
+    next.dirty_pct = buffered ? 100.0f * next.spi_bytes / (frame.width() * frame.height() * sizeof(uint16_t)) : 100.0f;
+    next.over_budget = overBudgetTotal;
+    next.buffered = buffered;
+
+    withPending([&](PendingState&) { stats = next; });
+    acc = {};
+}
+
+static void displayTask(void* param) {
+    TickType_t lastWake = xTaskGetTickCount();
+
+    // Direct drawing flickers and costs SPI time per draw call, so keep it slow
+    const TickType_t period = pdMS_TO_TICKS(buffered ? DISPLAY_FRAME_INTERVAL_MS : DISPLAY_UPDATE_INTERVAL_MS);
+
+    while (true) {
+        bool powerOn = true;
+        withPending([&](PendingState& p) { powerOn = p.powerOn; });
+
+        if (!powerOn) {
+            // Sleep the panel and block until displaySetPower(true)
+            M5.Lcd.waitDMA();
+            M5.Lcd.sleep();
+            while (!powerOn) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                withPending([&](PendingState& p) { powerOn = p.powerOn; });
+            }
+            M5.Lcd.wakeup();
+
+            // The panel may have lost its contents; redraw and push everything
+            withPending([&](PendingState& p) { p.fullRedraw = true; });
+            panelStale = true;
+            lastWake = xTaskGetTickCount();
+        }
+
+        bool full = takePendingState();
+
+        int64_t start = esp_timer_get_time();
+        frameStartUs = start;
+        if (buffered) {
+            // The previous push may still be reading the frame
+            M5.Lcd.waitDMA();
+        }
+        renderFrame(full);
+
+        int64_t rendered = esp_timer_get_time();
+        uint32_t bytes = buffered ? pushDirtyTiles() : 0;
+        int64_t pushed = esp_timer_get_time();
+
+        recordFrame(rendered - start, pushed - rendered, bytes);
+
+        vTaskDelayUntil(&lastWake, period);
+    }
 }
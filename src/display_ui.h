@@ -3,13 +3,34 @@
 
 #include "imu_sampler.h"
 
-// Initialize the display
+// Screens selectable with the touch buttons
+enum DisplayScreen {
+    SCREEN_GAUGE = 0,      // RMS gauge (default)
+    SCREEN_TREND,          // Scrolling RMS/peak history
+    SCREEN_SPECTRUM,       // Latest window's spectrum
+    SCREEN_DIAGNOSTICS,    // Firmware self-profiling
+    SCREEN_COUNT
+};
+
+// Display task statistics over the last second of frames
+struct DisplayStats {
+    float fps;               // Frames rendered
+    uint32_t render_us;      // Mean time drawing into the frame sprite
+    uint32_t push_us;        // Mean time diffing and queuing dirty regions
+    uint32_t frame_max_us;   // Worst render + push time
+    uint32_t spi_bytes;      // Mean pixel bytes sent to the panel per frame
+    float dirty_pct;         // Mean share of the screen pushed per frame
+    uint32_t over_budget;    // Frames over DISPLAY_RENDER_BUDGET_US since boot
+    bool buffered;           // false if the frame sprite could not be allocated
+};
+
+// Initialize the display and start the display task
 void displayInit();
 
-// Draw the main status screen with all information
+// Force a full redraw of the current screen
 void displayDrawStatusScreen();
 
-// Update the display with latest data
+// Hand the latest status (WiFi, AWS, battery) to the display task
 // Call this periodically from main loop
 void displayUpdate();
 
@@ -17,7 +38,21 @@ void displayUpdate();
 void displaySetWiFiStatus(bool connected);
 void displaySetAWSStatus(bool connected);
 
+// Switch screens
+void displaySetScreen(DisplayScreen screen);
+void displayNextScreen();
+
 // Set latest metrics for display
 void displaySetMetrics(const VibrationMetrics& metrics);
 
+// Show a fatal error message on top of the current screen
+void displayShowError(const char* message);
+
+// Put the panel to sleep and pause the display task, or wake both
+// (backlight power is switched by the power manager)
+void displaySetPower(bool on);
+
+// Get display task statistics
+void displayGetStats(DisplayStats& stats);
+
 #endif // DISPLAY_UI_H
@@ -0,0 +1,100 @@
+#include "fault_classifier.h"
+#include "fault_model.h"
+#include <math.h>
+
+// Keep the model within its flash and time bounds whatever was exported
+#if FAULT_MODEL_TREES * FAULT_MODEL_DEPTH > FAULT_MAX_COMPARISONS
+#error "Fault model exceeds FAULT_MAX_COMPARISONS; export fewer or shallower trees"
+#endif
+static_assert(sizeof(FAULT_MODEL_NODES) + sizeof(FAULT_MODEL_LEAVES) + sizeof(FAULT_MODEL_ROOTS) <= FAULT_MODEL_MAX_BYTES,
+              "Fault model exceeds FAULT_MODEL_MAX_BYTES");
+
+static const char* const CLASS_NAMES[FAULT_CLASS_COUNT] = {"normal", "imbalance", "looseness", "bearing"};
+
+static int16_t toFixed(float value, float scale) {
+    float v = value * scale;
+    if (v > 32767.0f) return 32767;
+    if (v < -32767.0f) return -32767;
+    return (int16_t)lroundf(v);
+}
+
+void faultExtractFeatures(const VibrationSpectrum& spectrum, float acRmsG, float acPeakG,
+                          FaultFeatures& out) {
+    // Band energies; the spectrum holds peak amplitude per band
+    float total = 0.0f;
+    float weighted = 0.0f;
+    float hf = 0.0f;
+    int dominant = 0;
+    for (int b = 0; b < SPECTRUM_BANDS; b++) {
+        float e = spectrum.bands_g[b] * spectrum.bands_g[b];
+        float centreHz = (b + 0.5f) * spectrum.band_hz;
+        total += e;
+        weighted += e * centreHz;
+        if (centreHz > FAULT_HF_HZ) {
+            hf += e;
+        }
+        if (e > spectrum.bands_g[dominant] * spectrum.bands_g[dominant]) {
+            dominant = b;
+        }
+    }
+
+    // Harmonics of the strongest band (band 0 holds no running speed)
+    float harmonics = 0.0f;
+    if (dominant > 0) {
+        for (int k = 2; k <= 5 && k * dominant < SPECTRUM_BANDS; k++) {
+            float a = spectrum.bands_g[k * dominant];
+            harmonics += a * a;
+        }
+    }
+
+    float inv = total > 0.0f ? 1.0f / total : 0.0f;
+    float domEnergy = spectrum.bands_g[dominant] * spectrum.bands_g[dominant];
+
+    out.v[FAULT_F_RMS_MG] = toFixed(acRmsG, 1000.0f);
+    out.v[FAULT_F_CREST] = toFixed(acRmsG > 0.0f ? acPeakG / acRmsG : 0.0f, 100.0f);
+    out.v[FAULT_F_DOM_HZ] = toFixed((dominant + 0.5f) * spectrum.band_hz, 10.0f);
+    out.v[FAULT_F_DOM_FRAC] = toFixed(domEnergy * inv, 10000.0f);
+    out.v[FAULT_F_HARM_FRAC] = toFixed(harmonics * inv, 10000.0f);
+    out.v[FAULT_F_HF_FRAC] = toFixed(hf * inv, 10000.0f);
+    out.v[FAULT_F_CENTROID_HZ] = toFixed(weighted * inv, 10.0f);
+}
+
+void faultClassify(const FaultFeatures& features, FaultResult& out) {
+    uint32_t votes[FAULT_CLASS_COUNT] = {};
+
+    for (int t = 0; t < FAULT_MODEL_TREES; t++) {
+        uint16_t index = FAULT_MODEL_ROOTS[t];
+        // Depth bound also guards against a malformed model
+        for (int depth = 0; depth < FAULT_MODEL_DEPTH && !(index & FAULT_NODE_LEAF); depth++) {
+            const FaultNode& node = FAULT_MODEL_NODES[index];
+            index = node.child[features.v[node.feature] > node.threshold];
+        }
+        if (!(index & FAULT_NODE_LEAF)) {
+            continue;
+        }
+
+        const uint8_t* leaf = FAULT_MODEL_LEAVES[index & ~FAULT_NODE_LEAF];
+        for (int c = 0; c < FAULT_CLASS_COUNT; c++) {
+            votes[c] += leaf[c];
+        }
+    }
+
+    uint8_t best = 0;
+    for (uint8_t c = 1; c < FAULT_CLASS_COUNT; c++) {
+        if (votes[c] > votes[best]) {
+            best = c;
+        }
+    }
+
+    uint32_t confidence = (votes[best] * 100 + 255 * FAULT_MODEL_TREES / 2) / (255 * FAULT_MODEL_TREES);
+    out.label = best;
+    out.confidence = confidence > 0 ? (uint8_t)confidence : 1;
+}
+
+const char* faultClassName(uint8_t label) {
+    return label < FAULT_CLASS_COUNT ? CLASS_NAMES[label] : "";
+}
+
+size_t faultModelBytes() {
+    return sizeof(FAULT_MODEL_NODES) + sizeof(FAULT_MODEL_LEAVES) + sizeof(FAULT_MODEL_ROOTS);
+}
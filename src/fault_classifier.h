@@ -0,0 +1,71 @@
+#ifndef FAULT_CLASSIFIER_H
+#define FAULT_CLASSIFIER_H
+
+// Portable (no Arduino dependencies) so the host-side tools can share it
+//
+// Machine fault classifier on window features: a small decision-tree
+// ensemble compiled into flash (fault_model.h, generated and benchmarked
+// by extras/fault_bench). Features are fixed point and the trees compare
+// integers only, so one inference costs at most
+// FAULT_MODEL_TREES x FAULT_MODEL_DEPTH comparisons and no allocation.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "spectrum.h"
+
+// Class ids are part of the telemetry block format: append only
+enum FaultClass : uint8_t {
+    FAULT_NORMAL = 0,
+    FAULT_IMBALANCE,     // Strong, clean 1x running speed component
+    FAULT_LOOSENESS,     // Running speed with a train of harmonics
+    FAULT_BEARING,       // Impulsive, high-frequency resonance (crest factor, HF energy)
+    FAULT_CLASS_COUNT
+};
+
+// Features in fixed point, in the units the model thresholds use
+enum FaultFeature : uint8_t {
+    FAULT_F_RMS_MG = 0,   // AC RMS of |accel|, mg
+    FAULT_F_CREST,        // AC peak / AC RMS, x100
+    FAULT_F_DOM_HZ,       // Centre of the strongest spectrum band, Hz x10
+    FAULT_F_DOM_FRAC,     // Strongest band's share of spectral energy, x10000
+    FAULT_F_HARM_FRAC,    // Share of the bands at 2x..5x the strongest, x10000
+    FAULT_F_HF_FRAC,      // Share above FAULT_HF_HZ, x10000
+    FAULT_F_CENTROID_HZ,  // Spectral centroid, Hz x10
+    FAULT_FEATURE_COUNT
+};
+
+#define FAULT_HF_HZ  100.0f
+
+struct FaultFeatures {
+    int16_t v[FAULT_FEATURE_COUNT];
+};
+
+// One tree node; child indices with FAULT_NODE_LEAF set are leaves
+struct FaultNode {
+    uint8_t feature;
+    int16_t threshold;     // Go right if the feature is above it
+    uint16_t child[2];
+};
+
+#define FAULT_NODE_LEAF  0x8000
+
+struct FaultResult {
+    uint8_t label;         // FaultClass
+    uint8_t confidence;    // Ensemble vote share for the label, percent (1..100)
+};
+
+// Features of one window from its spectrum and the AC RMS / AC peak of
+// the acceleration magnitude (SlidingStats acRms/acPeak)
+void faultExtractFeatures(const VibrationSpectrum& spectrum, float acRmsG, float acPeakG,
+                          FaultFeatures& out);
+
+// Run the compiled-in model
+void faultClassify(const FaultFeatures& features, FaultResult& out);
+
+// Class name for telemetry ("" for an unknown id)
+const char* faultClassName(uint8_t label);
+
+// Bytes of model data in flash (nodes, leaves, roots)
+size_t faultModelBytes();
+
+#endif // FAULT_CLASSIFIER_H
@@ -0,0 +1,282 @@
+#ifndef FAULT_MODEL_H
+#define FAULT_MODEL_H
+
+// Generated by extras/fault_bench --export (seed 1, 800 windows per class,
+// synthetic signatures); do not edit. Included by fault_classifier.cpp and the bench.
+
+#include "fault_classifier.h"
+
+#define FAULT_MODEL_TREES  8
+#define FAULT_MODEL_DEPTH  6     // Longest root-to-leaf path
+
+static const uint16_t FAULT_MODEL_ROOTS[FAULT_MODEL_TREES] = {0x0000, 0x000e, 0x001f, 0x002d, 0x0041, 0x0053, 0x0064, 0x0074};
+
+static const FaultNode FAULT_MODEL_NODES[] = {
+    {2, 859, {0x0001, 0x000c}},
+    {0, 14, {0x0002, 0x0003}},
+    {1, 412, {0x8000, 0x8001}},
+    {3, 6804, {0x0004, 0x0008}},
+    {1, 167, {0x0005, 0x0006}},
+    {4, 337, {0x8002, 0x8003}},
+    {6, 194, {0x8004, 0x0007}},
+    {6, 1159, {0x8005, 0x8006}},
+    {5, 1723, {0x0009, 0x800b}},
+    {5, 492, {0x000a, 0x000b}},
+    {4, 975, {0x8007, 0x8008}},
+    {3, 7232, {0x8009, 0x800a}},
+    {0, 15, {0x800c, 0x000d}},
+    {5, 3187, {0x800d, 0x800e}},
+    {5, 6653, {0x000f, 0x001e}},
+    {1, 183, {0x0010, 0x0014}},
+    {4, 547, {0x0011, 0x0012}},
+    {6, 522, {0x800f, 0x8010}},
+    {3, 5185, {0x8011, 0x0013}},
+    {6, 198, {0x8012, 0x8013}},
+    {1, 265, {0x0015, 0x0019}},
+    {0, 13, {0x8014, 0x0016}},
+    {0, 38, {0x0017, 0x0018}},
+    {3, 5994, {0x8015, 0x8016}},
+    {4, 270, {0x8017, 0x8018}},
+    {0, 14, {0x001a, 0x001c}},
+    {5, 6405, {0x8019, 0x001b}},
+    {6, 1300, {0x801a, 0x801b}},
+    {2, 742, {0x001d, 0x801e}},
+    {3, 2497, {0x801c, 0x801d}},
+    {0, 14, {0x801f, 0x8020}},
+    {0, 14, {0x8021, 0x0020}},
+    {5, 5312, {0x0021, 0x802f}},
+    {5, 168, {0x0022, 0x0027}},
+    {6, 228, {0x0023, 0x0025}},
+    {4, 3300, {0x8022, 0x0024}},
+    {0, 81, {0x8023, 0x8024}},
+    {4, 443, {0x0026, 0x8027}},
+    {3, 5338, {0x8025, 0x8026}},
+    {5, 569, {0x0028, 0x002b}},
+    {6, 358, {0x0029, 0x002a}},
+    {3, 6248, {0x8028, 0x8029}},
+    {3, 5911, {0x802a, 0x802b}},
+    {2, 859, {0x002c, 0x802e}},
+    {0, 20, {0x802c, 0x802d}},
+    {0, 14, {0x002e, 0x0033}},
+    {0, 13, {0x002f, 0x0032}},
+    {0, 12, {0x8030, 0x0030}},
+    {3, 2667, {0x0031, 0x8033}},
+    {4, 1013, {0x8031, 0x8032}},
+    {6, 685, {0x8034, 0x8035}},
+    {3, 6757, {0x0034, 0x003d}},
+    {5, 4595, {0x0035, 0x003b}},
+    {6, 252, {0x0036, 0x0038}},
+    {4, 676, {0x8036, 0x0037}},
+    {0, 64, {0x8037, 0x8038}},
+    {1, 166, {0x0039, 0x003a}},
+    {1, 159, {0x8039, 0x803a}},
+    {6, 1084, {0x803b, 0x803c}},
+    {2, 469, {0x003c, 0x803f}},
+    {3, 3880, {0x803d, 0x803e}},
+    {5, 1878, {0x003e, 0x0040}},
+    {1, 201, {0x8040, 0x003f}},
+    {1, 203, {0x8041, 0x8042}},
+    {5, 4954, {0x8043, 0x8044}},
+    {6, 1314, {0x0042, 0x004f}},
+    {0, 14, {0x0043, 0x0046}},
+    {0, 13, {0x0044, 0x0045}},
+    {5, 6371, {0x8045, 0x8046}},
+    {6, 679, {0x8047, 0x8048}},
+    {3, 6366, {0x0047, 0x004b}},
+    {2, 859, {0x0048, 0x004a}},
+    {6, 199, {0x8049, 0x0049}},
+    {4, 139, {0x804a, 0x804b}},
+    {5, 3429, {0x804c, 0x804d}},
+    {2, 742, {0x004c, 0x8052}},
+    {5, 1161, {0x004d, 0x004e}},
+    {5, 492, {0x804e, 0x804f}},
+    {4, 658, {0x8050, 0x8051}},
+    {5, 7022, {0x0050, 0x0052}},
+    {5, 6039, {0x8053, 0x0051}},
+    {0, 16, {0x8054, 0x8055}},
+    {3, 2091, {0x8056, 0x8057}},
+    {6, 1320, {0x0054, 0x0063}},
+    {1, 180, {0x0055, 0x0058}},
+    {6, 482, {0x0056, 0x0057}},
+    {4, 2028, {0x8058, 0x8059}},
+    {5, 2818, {0x805a, 0x805b}},
+    {1, 269, {0x0059, 0x005d}},
+    {2, 820, {0x005a, 0x005c}},
+    {0, 14, {0x805c, 0x005b}},
+    {3, 7082, {0x805d, 0x805e}},
+    {5, 3634, {0x805f, 0x8060}},
+    {0, 15, {0x005e, 0x0060}},
+    {5, 1419, {0x005f, 0x8063}},
+    {5, 1353, {0x8061, 0x8062}},
+    {6, 967, {0x0061, 0x0062}},
+    {0, 32, {0x8064, 0x8065}},
+    {2, 664, {0x8066, 0x8067}},
+    {0, 14, {0x8068, 0x8069}},
+    {5, 6884, {0x0065, 0x0071}},
+    {3, 8175, {0x0066, 0x0070}},
+    {1, 261, {0x0067, 0x006c}},
+    {1, 171, {0x0068, 0x0069}},
+    {5, 25, {0x806a, 0x806b}},
+    {6, 1080, {0x006a, 0x006b}},
+    {4, 776, {0x806c, 0x806d}},
+    {0, 28, {0x806e, 0x806f}},
+    {0, 14, {0x006d, 0x006e}},
+    {1, 411, {0x8070, 0x8071}},
+    {2, 742, {0x006f, 0x8074}},
+    {1, 348, {0x8072, 0x8073}},
+    {0, 14, {0x8075, 0x8076}},
+    {6, 1440, {0x0072, 0x807a}},
+    {5, 7393, {0x0073, 0x8079}},
+    {6, 1406, {0x8077, 0x8078}},
+    {0, 14, {0x807b, 0x0075}},
+    {2, 859, {0x0076, 0x8086}},
+    {4, 323, {0x0077, 0x007b}},
+    {5, 623, {0x807c, 0x0078}},
+    {6, 568, {0x0079, 0x007a}},
+    {3, 7023, {0x807d, 0x807e}},
+    {5, 4869, {0x807f, 0x8080}},
+    {3, 7301, {0x007c, 0x8085}},
+    {1, 170, {0x007d, 0x007e}},
+    {5, 415, {0x8081, 0x8082}},
+    {0, 24, {0x8083, 0x8084}},
+};
+
+static const uint8_t FAULT_MODEL_LEAVES[][FAULT_CLASS_COUNT] = {
+    {255, 0, 0, 0},
+    {204, 0, 0, 51},
+    {0, 255, 0, 0},
+    {0, 77, 179, 0},
+    {0, 255, 0, 0},
+    {0, 2, 251, 2},
+    {0, 0, 0, 255},
+    {0, 255, 0, 0},
+    {0, 209, 46, 0},
+    {0, 153, 102, 0},
+    {0, 255, 0, 0},
+    {0, 0, 255, 0},
+    {255, 0, 0, 0},
+    {0, 0, 128, 128},
+    {0, 0, 0, 255},
+    {0, 255, 0, 0},
+    {0, 0, 255, 0},
+    {0, 0, 255, 0},
+    {0, 255, 0, 0},
+    {0, 0, 255, 0},
+    {255, 0, 0, 0},
+    {0, 18, 222, 15},
+    {0, 252, 3, 0},
+    {0, 60, 169, 26},
+    {0, 2, 251, 3},
+    {255, 0, 0, 0},
+    {102, 0, 0, 153},
+    {255, 0, 0, 0},
+    {0, 0, 43, 213},
+    {0, 7, 240, 7},
+    {0, 0, 0, 255},
+    {255, 0, 0, 0},
+    {0, 0, 0, 255},
+    {255, 0, 0, 0},
+    {0, 255, 0, 0},
+    {0, 102, 153, 0},
+    {0, 153, 102, 0},
+    {0, 153, 102, 0},
+    {0, 255, 0, 0},
+    {0, 0, 255, 0},
+    {0, 64, 191, 0},
+    {0, 255, 0, 0},
+    {0, 0, 255, 0},
+    {0, 228, 27, 0},
+    {18, 114, 97, 26},
+    {0, 2, 252, 1},
+    {0, 0, 0, 255},
+    {0, 0, 0, 255},
+    {255, 0, 0, 0},
+    {204, 0, 0, 51},
+    {255, 0, 0, 0},
+    {255, 0, 0, 0},
+    {204, 0, 51, 0},
+    {255, 0, 0, 0},
+    {0, 255, 0, 0},
+    {0, 255, 0, 0},
+    {0, 34, 221, 0},
+    {0, 255, 0, 0},
+    {0, 153, 102, 0},
+    {0, 3, 249, 3},
+    {0, 0, 32, 223},
+    {0, 0, 32, 223},
+    {0, 0, 255, 0},
+    {0, 0, 0, 255},
+    {0, 255, 0, 0},
+    {0, 204, 51, 0},
+    {0, 255, 0, 0},
+    {0, 0, 255, 0},
+    {0, 0, 0, 255},
+    {255, 0, 0, 0},
+    {213, 0, 0, 43},
+    {204, 0, 51, 0},
+    {255, 0, 0, 0},
+    {0, 255, 0, 0},
+    {0, 33, 220, 1},
+    {0, 0, 254, 1},
+    {0, 0, 51, 204},
+    {0, 0, 0, 255},
+    {0, 255, 0, 0},
+    {0, 232, 23, 0},
+    {85, 85, 85, 0},
+    {0, 0, 255, 0},
+    {0, 0, 0, 255},
+    {0, 0, 0, 255},
+    {255, 0, 0, 0},
+    {0, 0, 0, 255},
+    {43, 0, 0, 213},
+    {0, 0, 0, 255},
+    {0, 255, 0, 0},
+    {0, 159, 96, 0},
+    {0, 0, 255, 0},
+    {0, 0, 213, 43},
+    {255, 0, 0, 0},
+    {0, 5, 251, 0},
+    {0, 246, 9, 0},
+    {0, 0, 51, 204},
+    {0, 0, 0, 255},
+    {255, 0, 0, 0},
+    {153, 102, 0, 0},
+    {255, 0, 0, 0},
+    {0, 15, 193, 46},
+    {0, 0, 255, 0},
+    {0, 0, 128, 128},
+    {0, 0, 0, 255},
+    {255, 0, 0, 0},
+    {0, 0, 0, 255},
+    {0, 255, 0, 0},
+    {0, 146, 109, 0},
+    {32, 34, 187, 2},
+    {1, 2, 251, 0},
+    {0, 0, 43, 213},
+    {0, 0, 0, 255},
+    {255, 0, 0, 0},
+    {170, 0, 0, 85},
+    {0, 2, 247, 6},
+    {0, 0, 0, 255},
+    {0, 0, 0, 255},
+    {255, 0, 0, 0},
+    {0, 255, 0, 0},
+    {0, 0, 0, 255},
+    {255, 0, 0, 0},
+    {0, 0, 0, 255},
+    {0, 0, 0, 255},
+    {255, 0, 0, 0},
+    {0, 255, 0, 0},
+    {0, 0, 255, 0},
+    {0, 255, 0, 0},
+    {0, 2, 252, 2},
+    {0, 0, 204, 51},
+    {0, 255, 0, 0},
+    {0, 0, 255, 0},
+    {11, 11, 177, 55},
+    {0, 0, 255, 0},
+    {0, 255, 0, 0},
+    {0, 0, 0, 255},
+};
+
+#endif // FAULT_MODEL_H
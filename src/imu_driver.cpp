@@ -0,0 +1,120 @@
+#include "imu_driver.h"
+#include <M5Unified.h>
+
+// MPU6886 registers
+#define MPU6886_SMPLRT_DIV    0x19
+#define MPU6886_CONFIG        0x1A
+#define MPU6886_GYRO_CONFIG   0x1B
+#define MPU6886_ACCEL_CONFIG  0x1C
+#define MPU6886_ACCEL_XOUT_H  0x3B   // Accel, temperature, gyro follow (big-endian int16 each)
+#define MPU6886_TEMP_OUT_H    0x41
+#define MPU6886_PWR_MGMT_1    0x6B
+#define MPU6886_WHO_AM_I      0x75
+#define MPU6886_ID            0x19
+#define MPU6886_LSB_PER_G     4096.0f   // ±8 g
+#define MPU6886_LSB_PER_DPS   16.4f     // ±2000 dps
+
+// ADXL345 registers
+#define ADXL345_DEVID         0x00
+#define ADXL345_ID            0xE5
+#define ADXL345_BW_RATE       0x2C
+#define ADXL345_POWER_CTL     0x2D
+#define ADXL345_DATA_FORMAT   0x31
+#define ADXL345_DATAX0        0x32   // X, Y, Z little-endian int16
+#define ADXL345_RATE_800HZ    0x0D
+#define ADXL345_MEASURE       0x08
+#define ADXL345_FULL_RES_16G  0x0B
+#define ADXL345_G_PER_LSB     0.0039f   // Full resolution: 3.9 mg/LSB at any range
+
+#define GROVE_I2C_FREQ  400000
+
+// External sensors share the Grove port (Port A) bus
+static bool groveBusBegin() {
+    return M5.Ex_I2C.isEnabled() || M5.Ex_I2C.begin();
+}
+
+bool InternalImuDriver::begin() {
+    return M5.Imu.isEnabled();
+}
+
+bool InternalImuDriver::read(ImuReading& reading) {
+    // One bus read covers accel and gyro
+    if (!M5.Imu.update()) {
+        return false;
+    }
+
+    auto data = M5.Imu.getImuData();
+    reading.accel[0] = data.accel.x;
+    reading.accel[1] = data.accel.y;
+    reading.accel[2] = data.accel.z;
+    reading.gyro[0] = data.gyro.x;
+    reading.gyro[1] = data.gyro.y;
+    reading.gyro[2] = data.gyro.z;
+    return true;
+}
+
+bool InternalImuDriver::readTemp(float& tempC) {
+    return M5.Imu.getTemp(&tempC);
+}
+
+bool Mpu6886Driver::begin() {
+    if (!groveBusBegin() || M5.Ex_I2C.readRegister8(_address, MPU6886_WHO_AM_I, GROVE_I2C_FREQ) != MPU6886_ID) {
+        return false;
+    }
+
+    M5.Ex_I2C.writeRegister8(_address, MPU6886_PWR_MGMT_1, 0x80, GROVE_I2C_FREQ);  // Reset
+    delay(10);
+    M5.Ex_I2C.writeRegister8(_address, MPU6886_PWR_MGMT_1, 0x01, GROVE_I2C_FREQ);  // Wake, PLL clock
+    delay(10);
+    M5.Ex_I2C.writeRegister8(_address, MPU6886_ACCEL_CONFIG, 0x10, GROVE_I2C_FREQ);
+    M5.Ex_I2C.writeRegister8(_address, MPU6886_GYRO_CONFIG, 0x18, GROVE_I2C_FREQ);
+    M5.Ex_I2C.writeRegister8(_address, MPU6886_CONFIG, 0x01, GROVE_I2C_FREQ);      // 176 Hz DLPF
+    M5.Ex_I2C.writeRegister8(_address, MPU6886_SMPLRT_DIV, 0x00, GROVE_I2C_FREQ);
+    return true;
+}
+
+bool Mpu6886Driver::read(ImuReading& reading) {
+    uint8_t d[14];
+    if (!M5.Ex_I2C.readRegister(_address, MPU6886_ACCEL_XOUT_H, d, sizeof(d), GROVE_I2C_FREQ)) {
+        return false;
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        reading.accel[axis] = (int16_t)((d[axis * 2] << 8) | d[axis * 2 + 1]) / MPU6886_LSB_PER_G;
+        reading.gyro[axis] = (int16_t)((d[8 + axis * 2] << 8) | d[9 + axis * 2]) / MPU6886_LSB_PER_DPS;
+    }
+    return true;
+}
+
+bool Mpu6886Driver::readTemp(float& tempC) {
+    uint8_t d[2];
+    if (!M5.Ex_I2C.readRegister(_address, MPU6886_TEMP_OUT_H, d, sizeof(d), GROVE_I2C_FREQ)) {
+        return false;
+    }
+    tempC = (int16_t)((d[0] << 8) | d[1]) / 326.8f + 25.0f;
+    return true;
+}
+
+bool Adxl345Driver::begin() {
+    if (!groveBusBegin() || M5.Ex_I2C.readRegister8(_address, ADXL345_DEVID, GROVE_I2C_FREQ) != ADXL345_ID) {
+        return false;
+    }
+
+    M5.Ex_I2C.writeRegister8(_address, ADXL345_BW_RATE, ADXL345_RATE_800HZ, GROVE_I2C_FREQ);
+    M5.Ex_I2C.writeRegister8(_address, ADXL345_DATA_FORMAT, ADXL345_FULL_RES_16G, GROVE_I2C_FREQ);
+    M5.Ex_I2C.writeRegister8(_address, ADXL345_POWER_CTL, ADXL345_MEASURE, GROVE_I2C_FREQ);
+    return true;
+}
+
+bool Adxl345Driver::read(ImuReading& reading) {
+    uint8_t d[6];
+    if (!M5.Ex_I2C.readRegister(_address, ADXL345_DATAX0, d, sizeof(d), GROVE_I2C_FREQ)) {
+        return false;
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        reading.accel[axis] = (int16_t)(d[axis * 2] | (d[axis * 2 + 1] << 8)) * ADXL345_G_PER_LSB;
+        reading.gyro[axis] = 0.0f;
+    }
+    return true;
+}
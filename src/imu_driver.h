@@ -0,0 +1,62 @@
+#ifndef IMU_DRIVER_H
+#define IMU_DRIVER_H
+
+#include <Arduino.h>
+
+// One reading: acceleration in g, angular rate in deg/s (0 without a gyro)
+struct ImuReading {
+    float accel[3];
+    float gyro[3];
+};
+
+// Sensor behind one sampler instance. read() is a single bus transaction,
+// so the sampling task can schedule every sensor's read back to back.
+class ImuDriver {
+public:
+    virtual ~ImuDriver() {}
+
+    // Probe and configure the part; false if it does not answer
+    virtual bool begin() = 0;
+
+    // Latest reading; false if none is available or the bus read failed
+    virtual bool read(ImuReading& reading) = 0;
+
+    // Die temperature, if the part has a sensor (read at window close)
+    virtual bool readTemp(float& tempC) { return false; }
+
+    virtual bool hasGyro() const { return true; }
+};
+
+// Core2's internal MPU6886 through M5Unified (M5.Imu)
+class InternalImuDriver : public ImuDriver {
+public:
+    bool begin() override;
+    bool read(ImuReading& reading) override;
+    bool readTemp(float& tempC) override;
+};
+
+// MPU6886 on the Grove port (M5Stack IMU Unit), ±8 g / ±2000 dps, 1 kHz internal rate
+class Mpu6886Driver : public ImuDriver {
+public:
+    explicit Mpu6886Driver(uint8_t address) : _address(address) {}
+    bool begin() override;
+    bool read(ImuReading& reading) override;
+    bool readTemp(float& tempC) override;
+
+private:
+    uint8_t _address;
+};
+
+// ADXL345 accelerometer on the Grove port, ±16 g full resolution, 800 Hz output rate
+class Adxl345Driver : public ImuDriver {
+public:
+    explicit Adxl345Driver(uint8_t address) : _address(address) {}
+    bool begin() override;
+    bool read(ImuReading& reading) override;
+    bool hasGyro() const override { return false; }
+
+private:
+    uint8_t _address;
+};
+
+#endif // IMU_DRIVER_H
@@ -1,37 +1,275 @@
 #include "imu_sampler.h"
+#include "clock_sync.h"
 #include "config.h"
+#include "diagnostics.h"
+#include "fault_classifier.h"
+#include "imu_driver.h"
+#include "mem_arena.h"
+#include "sliding_stats.h"
 #include <M5Unified.h>
+#include <esp_timer.h>
 
-// Sample buffer for one window
-static float sampleBuf[IMU_WINDOW_SAMPLES][3];
-static volatile int sampleIdx = 0;
-static volatile uint32_t totalSamples = 0;
+// MPU6886 registers used for FIFO bursts
+#define MPU6886_ADDR         0x68
+#define MPU6886_SMPLRT_DIV   0x19   // Rate = 1 kHz / (1 + div)
+#define MPU6886_GYRO_CONFIG  0x1B   // Bits 4:3 full scale (250/500/1000/2000 dps)
+#define MPU6886_ACCEL_CONFIG 0x1C   // Bits 4:3 full scale (2/4/8/16 g)
+#define MPU6886_FIFO_EN      0x23
+#define MPU6886_USER_CTRL    0x6A
+#define MPU6886_FIFO_COUNT   0x72   // 16-bit big-endian byte count
+#define MPU6886_FIFO_R_W     0x74
+#define MPU6886_FIFO_ACCEL_GYRO  0x18
+#define MPU6886_USER_FIFO_EN     0x40
+#define MPU6886_USER_FIFO_RST    0x04
+#define MPU6886_FIFO_PACKET  14     // Accel, temperature, gyro (big-endian int16 each)
+#define MPU6886_I2C_FREQ     400000
 
-// Latest computed metrics
-static VibrationMetrics latestMetrics = {0, 0, 0, 0, false};
-static SemaphoreHandle_t metricsMutex = nullptr;
+#if IMU_HOP_SAMPLES < 1 || IMU_HOP_SAMPLES > IMU_WINDOW_SAMPLES
+#error "IMU_HOP_SAMPLES must be between 1 and IMU_WINDOW_SAMPLES"
+#endif
+
+// Hops must tile a second so that every UTC second is a window boundary
+// on every device (checked at startup for the external sensors)
+#if 1000000 % IMU_SAMPLE_RATE_HZ != 0 || 1000000 % (1000000 / IMU_SAMPLE_RATE_HZ * IMU_HOP_SAMPLES) != 0
+#error "IMU_HOP_SAMPLES at IMU_SAMPLE_RATE_HZ must divide one second evenly"
+#endif
+
+// Per-sensor sampler settings; the internal IMU is always sensor 0
+struct SensorConfig {
+    const char* name;
+    ImuDriver* driver;
+    uint16_t rateHz;           // Divides IMU_SAMPLE_RATE_HZ
+    uint16_t windowSamples;    // <= IMU_WINDOW_SAMPLES
+    uint16_t hopSamples;
+    uint32_t historyWindows;
+};
+
+static InternalImuDriver internalImu;
+#if IMU_EXT_MPU6886
+static Mpu6886Driver groveMpu6886(0x68);
+#endif
+#if IMU_EXT_ADXL345
+static Adxl345Driver groveAdxl345(0x53);
+#endif
+
+static const SensorConfig SENSOR_CONFIGS[IMU_MAX_SENSORS] = {
+    {IMU_INTERNAL_NAME, &internalImu, IMU_SAMPLE_RATE_HZ, IMU_WINDOW_SAMPLES, IMU_HOP_SAMPLES, IMU_HISTORY_WINDOWS},
+#if IMU_EXT_MPU6886
+    {IMU_EXT_MPU6886_NAME, &groveMpu6886, IMU_EXT_MPU6886_RATE_HZ, IMU_EXT_MPU6886_WINDOW, IMU_EXT_MPU6886_HOP, IMU_EXT_HISTORY_WINDOWS},
+#endif
+#if IMU_EXT_ADXL345
+    {IMU_EXT_ADXL345_NAME, &groveAdxl345, IMU_EXT_ADXL345_RATE_HZ, IMU_EXT_ADXL345_WINDOW, IMU_EXT_ADXL345_HOP, IMU_EXT_HISTORY_WINDOWS},
+#endif
+};
+
+// Arena bytes for one sensor: sample timestamps, window history and the
+// sample ring, rounded up to the arena's 16-byte alignment
+static constexpr size_t sensorArenaBytes(size_t windowSamples, size_t historyWindows) {
+    return (windowSamples * (sizeof(int64_t) + 3 * sizeof(float)) +
+            historyWindows * sizeof(VibrationMetrics) + 15) & ~(size_t)15;
+}
+
+// External sensors are checked at the longest window they may configure
+static_assert(sensorArenaBytes(IMU_WINDOW_SAMPLES, IMU_HISTORY_WINDOWS) +
+              (IMU_MAX_SENSORS - 1) * sensorArenaBytes(IMU_WINDOW_SAMPLES, IMU_EXT_HISTORY_WINDOWS) <=
+              MEM_ARENA_IMU_KB * 1024UL,
+              "MEM_ARENA_IMU_KB too small for the configured sensors' buffers and history");
+
+// Sliding window statistics sized for the longest window. RMS and peak
+// are kept up to date per sample (running sums, monotonic-deque max/min),
+// so closing a window costs O(1) rather than a pass over the buffer.
+typedef SlidingStats<IMU_WINDOW_SAMPLES> WindowStats;
+
+// The statistics are touched on every sample, out of order, at the IMU
+// task's priority: internal RAM, not the PSRAM arena (~10 KB each)
+#define IMU_GYRO_SENSORS  (1 + IMU_EXT_MPU6886)
+static WindowStats magStatsPool[IMU_MAX_SENSORS];
+static WindowStats gyroStatsPool[IMU_GYRO_SENSORS][3];
+static uint8_t gyroStatsUsed = 0;
+
+// Shared by all samplers; only the sampling task computes spectra
+static VibrationSpectrum scratchSpectrum = {};
+
+// One sensor's sampling engine: sample ring, sliding statistics, UTC-aligned
+// window closing, and the latest metrics, history and spectrum for readers
+// on other tasks (guarded by its own mutex). The sample ring and history
+// live in ARENA_IMU.
+class ImuSampler {
+public:
+    bool begin(uint8_t index, const SensorConfig& cfg);
+
+    // Read the sensor if it is due on this tick of the sampling task
+    void poll(uint32_t tick);
+
+    // Collect one window through the internal MPU6886's FIFO
+    void burst();
+
+    void resetWindow();
+
+    const char* name() const { return _cfg->name; }
+    uint64_t sampleCount() const;
+    void getSampleRing(ImuSampleRing& ring) const;
+
+    bool getLatestMetrics(VibrationMetrics& metrics);
+    size_t getHistory(uint32_t afterSeq, VibrationMetrics* out, size_t max);
+    uint32_t getLatestSeq();
+    bool getLatestSpectrum(VibrationSpectrum& spectrum);
+    void getCostStats(ImuCostStats& stats);
+
+private:
+    void store(int64_t timeUs, const ImuReading& reading);
+    bool windowReady() const;
+    uint16_t samplesSince(uint64_t utcUs) const;
+    uint64_t windowBoundaryDue(uint64_t utcUs);
+    void computeMetrics(uint64_t closeUtcUs);
+
+    const SensorConfig* _cfg = nullptr;
+    uint8_t _index = 0;
+    uint32_t _divider = 1;            // Read on every _divider-th task tick...
+    uint32_t _phase = 0;              // ...the one where tick % _divider == _phase
+    int64_t _sampleUs = 0;            // Sample period
+    int64_t _hopUs = 0;               // Hop duration
+
+    float (*_sampleBuf)[3] = nullptr;  // xyz ring, for the spectrum and live stream (sample k at k % windowSamples)
+    uint32_t _ringHead = 0;            // Slot of the next sample (_totalSamples % windowSamples), the oldest once full
+    int64_t* _sampleTimeUs = nullptr;  // esp_timer time of each ring sample
+    WindowStats* _magStats = nullptr;  // |accel| in g
+    WindowStats* _gyroStats = nullptr; // [3] angular rate in deg/s (nullptr without a gyro)
+    uint32_t _hopSamples = 0;          // Samples since the last window closed
+    uint32_t _spectrumSamples = 0;     // Samples since the last spectrum
+    uint64_t _nextBoundaryUs = 0;      // UTC time the next window closes (0 = not yet aligned)
+    volatile uint64_t _totalSamples = 0;
+
+    // Sampling path cost since the last window closed
+    uint64_t _readUsAcc = 0;
+    uint64_t _processUsAcc = 0;
+    uint32_t _missed = 0;
+
+    // Latest fault classification (confidence 0 until the first)
+    FaultResult _fault = {};
+    uint32_t _classifyUs = 0;
+    uint32_t _classifyOverBudget = 0;
+
+    // Guarded by _mutex
+    VibrationMetrics _latestMetrics = {};
+    VibrationMetrics* _history = nullptr;
+    uint32_t _latestSeq = 0;
+    VibrationSpectrum _latestSpectrum = {};
+    ImuCostStats _latestCost = {};
+    SemaphoreHandle_t _mutex = nullptr;
+};
+
+static ImuSampler samplers[IMU_MAX_SENSORS];
+static uint8_t sensorCount = 0;
+static volatile uint32_t burstIntervalMs = 0;
+static volatile bool burstWaiting = false;    // Between bursts, until nextBurstMs
+static volatile uint32_t nextBurstMs = 0;
+static TaskHandle_t imuTaskHandle = nullptr;
 
-// Forward declarations
 static void imuTask(void* param);
-static void computeMetrics();
 
-void imuStartSampling() {
-    // Create mutex for thread-safe metrics access
-    metricsMutex = xSemaphoreCreateMutex();
+bool ImuSampler::begin(uint8_t index, const SensorConfig& cfg) {
+    int64_t hopUs = 1000000LL / cfg.rateHz * cfg.hopSamples;
+    if (IMU_SAMPLE_RATE_HZ % cfg.rateHz != 0 || 1000000 % cfg.rateHz != 0 ||
+        cfg.windowSamples > IMU_WINDOW_SAMPLES || cfg.hopSamples < 1 || cfg.hopSamples > cfg.windowSamples ||
+        1000000 % hopUs != 0) {
+        Serial.printf("ERROR: IMU sensor %s: unsupported rate, window or hop\n", cfg.name);
+        return false;
+    }
+
+    if (!cfg.driver->begin()) {
+        Serial.printf("ERROR: IMU sensor %s not found\n", cfg.name);
+        return false;
+    }
 
-    if (metricsMutex == nullptr) {
+    if (cfg.driver->hasGyro() && gyroStatsUsed == IMU_GYRO_SENSORS) {
+        Serial.printf("ERROR: IMU sensor %s: no gyro statistics left (IMU_GYRO_SENSORS)\n", cfg.name);
+        return false;
+    }
+
+    // Create mutex for thread-safe metrics access
+    _mutex = xSemaphoreCreateMutex();
+    if (_mutex == nullptr) {
         Serial.println("ERROR: Failed to create metrics mutex");
-        return;
+        return false;
     }
 
-    // Create IMU sampling task pinned to Core 1
+    // One arena block per sensor, taken last, so a failed sensor never
+    // holds arena space (timestamps first: every part stays 8-byte aligned)
+    uint8_t* block = (uint8_t*)memArenaAlloc(ARENA_IMU, sensorArenaBytes(cfg.windowSamples, cfg.historyWindows));
+    if (block == nullptr) {
+        Serial.printf("ERROR: IMU arena too small for sensor %s buffers and history\n", cfg.name);
+        vSemaphoreDelete(_mutex);
+        _mutex = nullptr;
+        return false;
+    }
+    _sampleTimeUs = (int64_t*)block;
+    _history = (VibrationMetrics*)(_sampleTimeUs + cfg.windowSamples);
+    _sampleBuf = (float(*)[3])(_history + cfg.historyWindows);
+
+    _magStats = &magStatsPool[index];
+    if (cfg.driver->hasGyro()) {
+        _gyroStats = gyroStatsPool[gyroStatsUsed++];
+    }
+
+    _cfg = &cfg;
+    _index = index;
+    _divider = IMU_SAMPLE_RATE_HZ / cfg.rateHz;
+    _phase = index % _divider;  // Spread slower sensors' reads over the ticks
+    _sampleUs = 1000000LL / cfg.rateHz;
+    _hopUs = hopUs;
+    resetWindow();
+
+    Serial.printf("IMU sensor %u (%s): %d Hz, %d sample window, %d sample hop\n",
+                  index, cfg.name, cfg.rateHz, cfg.windowSamples, cfg.hopSamples);
+    return true;
+}
+
+// Diagnostics "imu" section: sampling path cost per sensor (bus read,
+// per-sample work and window close)
+static void writeDiagSection(JsonVariant section) {
+    JsonArray imuList = section.to<JsonArray>();
+    for (uint8_t i = 0; i < imuGetSensorCount(); i++) {
+        ImuCostStats imuCost;
+        imuGetCostStats(imuCost, i);
+        if (!imuCost.valid) {
+            continue;
+        }
+        JsonObject imu = imuList.add<JsonObject>();
+        imu["name"] = imuGetSensorName(i);
+        imu["rate_hz"] = imuCost.rate_hz;
+        imu["read_us"] = imuCost.read_us;
+        imu["process_ns"] = imuCost.process_ns;
+        imu["compute_us"] = imuCost.compute_us;
+        imu["budget_pct"] = serialized(String(imuCost.budget_pct, 1));
+        imu["max_rate_hz"] = imuCost.max_rate_hz;
+        imu["missed"] = imuCost.missed;
+#if FAULT_CLASSIFIER_ENABLED
+        imu["classify_us"] = imuCost.classify_us;
+        imu["classify_over"] = imuCost.classify_over_budget;
+#endif
+    }
+}
+
+void imuStartSampling() {
+    diagRegisterSection("imu", writeDiagSection);
+
+    for (size_t i = 0; i < IMU_MAX_SENSORS; i++) {
+        if (samplers[sensorCount].begin(sensorCount, SENSOR_CONFIGS[i])) {
+            sensorCount++;
+        } else if (i == 0) {
+            return;  // Burst mode and the display rely on the internal IMU as sensor 0
+        }
+    }
+
+    // One task reads every sensor, so all bus reads of a tick run back to back
     BaseType_t result = xTaskCreatePinnedToCore(
         imuTask,
         "imu_sampler",
         IMU_TASK_STACK_SIZE,
         nullptr,
         IMU_TASK_PRIORITY,
-        nullptr,
+        &imuTaskHandle,
         IMU_TASK_CORE
     );
 
@@ -40,93 +278,520 @@ void imuStartSampling() {
         return;
     }
 
-    Serial.printf("IMU sampling started: %d Hz, %d sample window\n",
-                  IMU_SAMPLE_RATE_HZ, IMU_WINDOW_SAMPLES);
+    Serial.printf("IMU sampling started: %u sensor(s), %d Hz task tick\n", sensorCount, IMU_SAMPLE_RATE_HZ);
+}
+
+// Store one sample taken at esp_timer time timeUs: accel (g) into the
+// ring and its magnitude into the sliding statistics, gyro (dps) into the
+// per-axis sliding statistics
+inline void ImuSampler::store(int64_t timeUs, const ImuReading& reading) {
+    _sampleTimeUs[_ringHead] = timeUs;
+    float* s = _sampleBuf[_ringHead];
+    s[0] = reading.accel[0];
+    s[1] = reading.accel[1];
+    s[2] = reading.accel[2];
+
+    _magStats->push(sqrtf(s[0]*s[0] + s[1]*s[1] + s[2]*s[2]));
+    if (_gyroStats != nullptr) {
+        _gyroStats[0].push(reading.gyro[0]);
+        _gyroStats[1].push(reading.gyro[1]);
+        _gyroStats[2].push(reading.gyro[2]);
+    }
+
+    _hopSamples++;
+
+    if (++_ringHead == _cfg->windowSamples) {
+        _ringHead = 0;
+    }
+
+    // Publish the sample to lock-free ring readers after it is written
+    __sync_synchronize();
+    _totalSamples = _totalSamples + 1;
+}
+
+// Readers on other tasks: a 64-bit load is two 32-bit loads here, so
+// read until two agree (the count moves at most once per sample period)
+uint64_t ImuSampler::sampleCount() const {
+    uint64_t a, b;
+    do {
+        a = _totalSamples;
+        b = _totalSamples;
+    } while (a != b);
+    return a;
+}
+
+// A full window, and a hop's worth of new samples since the last one
+// (used until the clock is synced)
+bool ImuSampler::windowReady() const {
+    return _magStats->full() && _hopSamples >= _cfg->hopSamples;
+}
+
+// Ring samples stamped at or after utcUs. Assumes a full ring (only
+// called when a window closes): it is then in time order from its oldest
+// slot, _ringHead, so binary search the boundary.
+uint16_t ImuSampler::samplesSince(uint64_t utcUs) const {
+    uint32_t n = _cfg->windowSamples;
+    uint32_t lo = 0, hi = n;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        uint32_t slot = _ringHead + mid;
+        if (slot >= n) {
+            slot -= n;
+        }
+        if (clockUtcUs(_sampleTimeUs[slot]) < utcUs) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (uint16_t)(n - lo);
+}
+
+// With a synced clock, a window closes when a sample lands on or past the
+// next UTC hop boundary; it holds the samples before the boundary.
+// Returns the boundary to close at, or 0. Clock steps realign.
+uint64_t ImuSampler::windowBoundaryDue(uint64_t utcUs) {
+    uint64_t boundary = 0;
+    if (_nextBoundaryUs != 0 && utcUs >= _nextBoundaryUs && utcUs < _nextBoundaryUs + _hopUs) {
+        boundary = _nextBoundaryUs;
+    }
+    if (_nextBoundaryUs == 0 || utcUs >= _nextBoundaryUs || utcUs + _hopUs < _nextBoundaryUs) {
+        _nextBoundaryUs = (utcUs / _hopUs + 1) * _hopUs;
+    }
+    return _magStats->full() ? boundary : 0;
+}
+
+void ImuSampler::resetWindow() {
+    _magStats->reset(_cfg->windowSamples);
+    if (_gyroStats != nullptr) {
+        for (int axis = 0; axis < 3; axis++) {
+            _gyroStats[axis].reset(_cfg->windowSamples);
+        }
+    }
+    _hopSamples = 0;
+    _spectrumSamples = _cfg->windowSamples;  // First window gets a spectrum
+    _readUsAcc = 0;
+    _processUsAcc = 0;
+}
+
+void ImuSampler::poll(uint32_t tick) {
+    if (tick % _divider != _phase) {
+        return;
+    }
+
+    ImuReading reading;
+    int64_t readStart = esp_timer_get_time();
+    if (!_cfg->driver->read(reading)) {
+        _missed++;
+        return;
+    }
+    int64_t readEnd = esp_timer_get_time();
+
+    // Close on UTC boundaries once synced, before this sample (which
+    // belongs to the next window) goes in
+    uint64_t utcUs = clockUtcUs(readStart);
+    if (utcUs != 0) {
+        uint64_t boundary = windowBoundaryDue(utcUs);
+        if (boundary != 0) {
+            computeMetrics(boundary);
+        }
+    }
+
+    int64_t storeStart = esp_timer_get_time();
+    store(readStart, reading);
+    _readUsAcc += readEnd - readStart;
+    _processUsAcc += esp_timer_get_time() - storeStart;
+
+    // Until then, close a window every hop once the first one is full
+    if (utcUs == 0 && windowReady()) {
+        computeMetrics(0);
+    }
+}
+
+void imuSetBurstInterval(uint32_t intervalMs) {
+    burstIntervalMs = intervalMs;
+}
+
+bool imuGetNextBurst(uint32_t& atMs) {
+    atMs = nextBurstMs;
+    return burstWaiting;
+}
+
+static uint8_t imuReadRegister8(uint8_t reg) {
+    return M5.In_I2C.readRegister8(MPU6886_ADDR, reg, MPU6886_I2C_FREQ);
+}
+
+static void imuWriteRegister8(uint8_t reg, uint8_t value) {
+    M5.In_I2C.writeRegister8(MPU6886_ADDR, reg, value, MPU6886_I2C_FREQ);
+}
+
+// Collect one window through the IMU's hardware FIFO. The task sleeps
+// IMU_FIFO_DRAIN_MS between reads instead of waking at 500 Hz, which
+// lets the CPU light-sleep while the IMU keeps sampling.
+void ImuSampler::burst() {
+    uint8_t oldDiv = imuReadRegister8(MPU6886_SMPLRT_DIV);
+    uint8_t userCtrl = imuReadRegister8(MPU6886_USER_CTRL);
+    float lsbPerG = 16384.0f / (1 << ((imuReadRegister8(MPU6886_ACCEL_CONFIG) >> 3) & 0x03));
+    float lsbPerDps = 131.072f / (1 << ((imuReadRegister8(MPU6886_GYRO_CONFIG) >> 3) & 0x03));
+
+    imuWriteRegister8(MPU6886_SMPLRT_DIV, 1000 / _cfg->rateHz - 1);
+    imuWriteRegister8(MPU6886_USER_CTRL, userCtrl | MPU6886_USER_FIFO_RST);
+    imuWriteRegister8(MPU6886_FIFO_EN, MPU6886_FIFO_ACCEL_GYRO);
+
+    // Start on a UTC second when the clock is synced: sleep most of the
+    // way, then spin the last couple of milliseconds for a tight start
+    uint64_t startUtcUs = 0;
+    uint64_t utcUs = clockUtcUs(esp_timer_get_time());
+    if (utcUs != 0) {
+        startUtcUs = (utcUs / 1000000ULL + 1) * 1000000ULL;
+        int64_t startUs = esp_timer_get_time() + (int64_t)(startUtcUs - utcUs);
+        int64_t sleepMs = (startUs - esp_timer_get_time()) / 1000 - 2;
+        if (sleepMs > 0) {
+            vTaskDelay(pdMS_TO_TICKS(sleepMs));
+        }
+        while (esp_timer_get_time() < startUs) {
+        }
+    }
+    imuWriteRegister8(MPU6886_USER_CTRL, userCtrl | MPU6886_USER_FIFO_EN);
+    int64_t fifoStartUs = esp_timer_get_time();
+
+    // Give up if the FIFO stalls for three window lengths
+    int64_t deadline = esp_timer_get_time() + 3 * _sampleUs * _cfg->windowSamples;
+    uint8_t buf[MPU6886_FIFO_PACKET * 8];
+    resetWindow();
+
+    while (!_magStats->full() && esp_timer_get_time() < deadline) {
+        vTaskDelay(pdMS_TO_TICKS(IMU_FIFO_DRAIN_MS));
+
+        uint8_t count[2];
+        if (!M5.In_I2C.readRegister(MPU6886_ADDR, MPU6886_FIFO_COUNT, count, 2, MPU6886_I2C_FREQ)) {
+            continue;
+        }
+
+        int packets = ((count[0] << 8) | count[1]) / MPU6886_FIFO_PACKET;
+        while (packets > 0 && !_magStats->full()) {
+            int n = min(packets, 8);
+            int64_t readStart = esp_timer_get_time();
+            if (!M5.In_I2C.readRegister(MPU6886_ADDR, MPU6886_FIFO_R_W, buf, n * MPU6886_FIFO_PACKET, MPU6886_I2C_FREQ)) {
+                _missed++;
+                break;
+            }
+            int64_t readEnd = esp_timer_get_time();
+            _readUsAcc += readEnd - readStart;
+
+            for (int p = 0; p < n && !_magStats->full(); p++) {
+                const uint8_t* d = buf + p * MPU6886_FIFO_PACKET;
+                ImuReading reading;
+                for (int axis = 0; axis < 3; axis++) {
+                    reading.accel[axis] = (int16_t)((d[axis * 2] << 8) | d[axis * 2 + 1]) / lsbPerG;
+                    reading.gyro[axis] = (int16_t)((d[8 + axis * 2] << 8) | d[9 + axis * 2]) / lsbPerDps;
+                }
+                // FIFO samples are evenly spaced from the start, not stamped
+                store(fifoStartUs + (int64_t)_magStats->size() * _sampleUs, reading);
+            }
+            _processUsAcc += esp_timer_get_time() - readEnd;
+            packets -= n;
+        }
+    }
+
+    // Stop the FIFO and restore the rate M5Unified configured
+    imuWriteRegister8(MPU6886_FIFO_EN, 0);
+    imuWriteRegister8(MPU6886_USER_CTRL, userCtrl | MPU6886_USER_FIFO_RST);
+    imuWriteRegister8(MPU6886_USER_CTRL, userCtrl);
+    imuWriteRegister8(MPU6886_SMPLRT_DIV, oldDiv);
+
+    // One window per burst, whatever the hop
+    if (_magStats->full()) {
+        computeMetrics(startUtcUs != 0 ? startUtcUs + _sampleUs * _cfg->windowSamples : 0);
+    } else {
+        Serial.printf("WARNING: IMU burst incomplete (%u samples)\n", (unsigned)_magStats->size());
+    }
+    resetWindow();
 }
 
 static void imuTask(void* param) {
     TickType_t lastWake = xTaskGetTickCount();
     const TickType_t period = pdMS_TO_TICKS(1000 / IMU_SAMPLE_RATE_HZ);
+    uint32_t tick = 0;
 
     while (true) {
-        // Update IMU and check for new data
-        if (M5.Imu.update()) {
-            auto data = M5.Imu.getImuData();
-
-            // Store acceleration values (in g)
-            sampleBuf[sampleIdx][0] = data.accel.x;
-            sampleBuf[sampleIdx][1] = data.accel.y;
-            sampleBuf[sampleIdx][2] = data.accel.z;
-
-            sampleIdx++;
-            totalSamples++;
-
-            // When window is full, compute metrics
-            if (sampleIdx >= IMU_WINDOW_SAMPLES) {
-                computeMetrics();
-                sampleIdx = 0;
+        if (burstIntervalMs > 0) {
+            // External sensors pause; bursts only cover the internal IMU's FIFO
+            uint32_t burstStart = millis();
+            samplers[0].burst();
+
+            // Wait for the next burst in short steps timed by millis(): the
+            // loop light-sleeps between bursts, which stops the tick count
+            // but not esp_timer
+            nextBurstMs = burstStart + burstIntervalMs;
+            burstWaiting = true;
+            int32_t remaining;
+            while (burstIntervalMs > 0 && (remaining = (int32_t)(nextBurstMs - millis())) > 0) {
+                vTaskDelay(pdMS_TO_TICKS(min(remaining, (int32_t)IMU_BURST_WAIT_STEP_MS)) + 1);
             }
+            burstWaiting = false;
+            lastWake = xTaskGetTickCount();
+            continue;
+        }
+
+        // Every sensor due on this tick, back to back
+        for (uint8_t i = 0; i < sensorCount; i++) {
+            samplers[i].poll(tick);
         }
+        tick++;
 
         // Maintain precise timing
         vTaskDelayUntil(&lastWake, period);
     }
 }
 
-static void computeMetrics() {
-    float sumSq = 0.0f;
-    float maxMag = 0.0f;
+// Close the window over the last windowSamples samples. closeUtcUs is the
+// aligned UTC boundary it closes at, or 0 to stamp it now.
+void ImuSampler::computeMetrics(uint64_t closeUtcUs) {
+    // Stamp the window as it closes, before any processing delay
+    int64_t windowUs = esp_timer_get_time();
+    uint64_t epochMs = (closeUtcUs != 0 ? closeUtcUs : clockUtcUs(windowUs)) / 1000;
+
+    // Samples actually stored between the window's UTC boundaries: missed
+    // reads and a slow read cadence stretch the last windowSamples samples
+    // past the window's start, so fewer of them count
+    uint64_t openUtcUs = closeUtcUs != 0 ? closeUtcUs - (uint64_t)_sampleUs * _cfg->windowSamples : 0;
+    uint16_t sampleCount = closeUtcUs != 0 ? samplesSince(openUtcUs) : (uint16_t)_magStats->size();
 
-    // Calculate RMS and peak from the sample window
-    for (int i = 0; i < IMU_WINDOW_SAMPLES; i++) {
-        // Compute magnitude: sqrt(x^2 + y^2 + z^2)
-        float x = sampleBuf[i][0];
-        float y = sampleBuf[i][1];
-        float z = sampleBuf[i][2];
-        float mag = sqrtf(x*x + y*y + z*z);
+    // Start at the first sample counted; the ring's oldest entry (the next
+    // one to be overwritten) when they all are
+    uint64_t startUtcUs = openUtcUs;
+    if (sampleCount > 0) {
+        uint32_t first = _ringHead + (_cfg->windowSamples - sampleCount);
+        if (first >= _cfg->windowSamples) {
+            first -= _cfg->windowSamples;
+        }
+        startUtcUs = clockUtcUs(_sampleTimeUs[first]);
+    }
 
-        sumSq += mag * mag;
+    // RMS and peak of the magnitude are already up to date (over the last
+    // windowSamples samples, which reach back before startUtcUs when
+    // sampleCount falls short)
+    float rms = _magStats->rms();
+    float peak = _magStats->max();
 
-        if (mag > maxMag) {
-            maxMag = mag;
+    float gyroRms[3] = {};
+    float gyroPeak[3] = {};
+    if (_gyroStats != nullptr) {
+        for (int axis = 0; axis < 3; axis++) {
+            gyroRms[axis] = _gyroStats[axis].acRms();
+            gyroPeak[axis] = _gyroStats[axis].acPeak();
         }
     }
 
+    // Spectrum once per window length, not per hop, so its cost does not
+    // scale with the hop rate. Outside the lock; the ring is not written
+    // until we return.
+    _spectrumSamples += _hopSamples;
+    bool spectrumDue = _spectrumSamples >= _cfg->windowSamples;
+    if (spectrumDue) {
+        spectrumCompute(_sampleBuf, _cfg->windowSamples, _ringHead,
+                        _cfg->rateHz, scratchSpectrum);
+        _spectrumSamples = 0;
+
+#if FAULT_CLASSIFIER_ENABLED
+        // Classify on the fresh spectrum; hops in between carry the result
+        int64_t classifyStart = esp_timer_get_time();
+        FaultFeatures features;
+        faultExtractFeatures(scratchSpectrum, _magStats->acRms(), _magStats->acPeak(), features);
+        faultClassify(features, _fault);
+        _classifyUs = esp_timer_get_time() - classifyStart;
+        if (_classifyUs > FAULT_CLASSIFY_BUDGET_US) {
+            _classifyOverBudget++;
+        }
+#endif
+    }
+
+    float temp = 0;
+    bool tempValid = _cfg->driver->readTemp(temp);
+
+    // Cost of this hop against its duration
+    uint32_t samples = _hopSamples > 0 ? _hopSamples : 1;
+    ImuCostStats cost;
+    cost.rate_hz = _cfg->rateHz;
+    cost.read_us = _readUsAcc / samples;
+    cost.process_ns = _processUsAcc * 1000 / samples;
+    cost.compute_us = esp_timer_get_time() - windowUs;
+    float perSampleUs = (float)(_readUsAcc + _processUsAcc + cost.compute_us) / samples;
+    cost.budget_pct = perSampleUs * _cfg->rateHz / 10000.0f;
+    cost.max_rate_hz = perSampleUs > 0 ? (uint32_t)(1000000.0f / perSampleUs) : 0;
+    cost.missed = _missed;
+    cost.classify_us = _classifyUs;
+    cost.classify_over_budget = _classifyOverBudget;
+    cost.valid = true;
+
+    _hopSamples = 0;
+    _readUsAcc = 0;
+    _processUsAcc = 0;
+
     // Update metrics with mutex protection
-    if (xSemaphoreTake(metricsMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        latestMetrics.rms_g = sqrtf(sumSq / IMU_WINDOW_SAMPLES);
-        latestMetrics.peak_g = maxMag;
-        latestMetrics.timestamp = millis();
-        latestMetrics.valid = true;
+    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        _latestMetrics.rms_g = rms;
+        _latestMetrics.peak_g = peak;
+        memcpy(_latestMetrics.gyro_rms_dps, gyroRms, sizeof(gyroRms));
+        memcpy(_latestMetrics.gyro_peak_dps, gyroPeak, sizeof(gyroPeak));
+        _latestMetrics.timestamp = millis();
+        _latestMetrics.epoch_ms = epochMs;
+        _latestMetrics.start_epoch_us = startUtcUs;
+        _latestMetrics.sample_count = sampleCount;
+        _latestMetrics.sensor = _index;
+        _latestMetrics.fault_class = _fault.label;
+        _latestMetrics.fault_confidence = _fault.confidence;
+        _latestMetrics.window_us = windowUs;
+        _latestMetrics.valid = true;
+        if (tempValid) {
+            _latestMetrics.temp_c = temp;
+        }
 
-        // Try to get IMU temperature if available
-        float temp = 0;
-        if (M5.Imu.getTemp(&temp)) {
-            latestMetrics.temp_c = temp;
+        _latestMetrics.seq = ++_latestSeq;
+        _history[_latestSeq % _cfg->historyWindows] = _latestMetrics;
+
+        if (spectrumDue) {
+            _latestSpectrum = scratchSpectrum;
+            _latestSpectrum.seq = _latestSeq;
         }
 
-        xSemaphoreGive(metricsMutex);
+        _latestCost = cost;
+
+        xSemaphoreGive(_mutex);
     }
 }
 
-bool imuGetLatestMetrics(VibrationMetrics& metrics) {
-    if (metricsMutex == nullptr) {
-        return false;
+bool ImuSampler::getLatestMetrics(VibrationMetrics& metrics) {
+    bool success = false;
+
+    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        if (_latestMetrics.valid) {
+            metrics = _latestMetrics;
+            success = true;
+        }
+        xSemaphoreGive(_mutex);
+    }
+
+    return success;
+}
+
+size_t ImuSampler::getHistory(uint32_t afterSeq, VibrationMetrics* out, size_t max) {
+    size_t copied = 0;
+
+    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        // Windows older than the ring are gone
+        uint32_t size = _cfg->historyWindows;
+        uint32_t oldest = _latestSeq >= size ? _latestSeq - size + 1 : 1;
+        uint32_t seq = afterSeq + 1 > oldest ? afterSeq + 1 : oldest;
+
+        for (; seq <= _latestSeq && copied < max; seq++) {
+            out[copied++] = _history[seq % size];
+        }
+        xSemaphoreGive(_mutex);
     }
 
+    return copied;
+}
+
+uint32_t ImuSampler::getLatestSeq() {
+    uint32_t seq = 0;
+
+    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        seq = _latestSeq;
+        xSemaphoreGive(_mutex);
+    }
+
+    return seq;
+}
+
+bool ImuSampler::getLatestSpectrum(VibrationSpectrum& spectrum) {
     bool success = false;
 
-    if (xSemaphoreTake(metricsMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        if (latestMetrics.valid) {
-            metrics = latestMetrics;
+    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        if (_latestSpectrum.valid) {
+            spectrum = _latestSpectrum;
             success = true;
         }
-        xSemaphoreGive(metricsMutex);
+        xSemaphoreGive(_mutex);
     }
 
     return success;
 }
 
-uint32_t imuGetSampleCount() {
-    return totalSamples;
+void ImuSampler::getCostStats(ImuCostStats& stats) {
+    stats = {};
+
+    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        stats = _latestCost;
+        xSemaphoreGive(_mutex);
+    }
+}
+
+void ImuSampler::getSampleRing(ImuSampleRing& ring) const {
+    ring.xyz = _sampleBuf;
+    ring.timeUs = _sampleTimeUs;
+    ring.size = _cfg->windowSamples;
+    ring.rateHz = _cfg->rateHz;
+}
+
+// Started sampler for a sensor index, or nullptr
+static ImuSampler* sampler(uint8_t sensor) {
+    return sensor < sensorCount ? &samplers[sensor] : nullptr;
+}
+
+uint8_t imuGetSensorCount() {
+    return sensorCount;
+}
+
+const char* imuGetSensorName(uint8_t sensor) {
+    ImuSampler* s = sampler(sensor);
+    return s != nullptr ? s->name() : "";
+}
+
+bool imuGetLatestMetrics(VibrationMetrics& metrics, uint8_t sensor) {
+    ImuSampler* s = sampler(sensor);
+    return s != nullptr && s->getLatestMetrics(metrics);
+}
+
+size_t imuGetHistory(uint32_t afterSeq, VibrationMetrics* out, size_t max, uint8_t sensor) {
+    ImuSampler* s = sampler(sensor);
+    return s != nullptr ? s->getHistory(afterSeq, out, max) : 0;
+}
+
+uint32_t imuGetLatestSeq(uint8_t sensor) {
+    ImuSampler* s = sampler(sensor);
+    return s != nullptr ? s->getLatestSeq() : 0;
+}
+
+bool imuGetLatestSpectrum(VibrationSpectrum& spectrum, uint8_t sensor) {
+    ImuSampler* s = sampler(sensor);
+    return s != nullptr && s->getLatestSpectrum(spectrum);
+}
+
+void imuGetCostStats(ImuCostStats& stats, uint8_t sensor) {
+    ImuSampler* s = sampler(sensor);
+    if (s != nullptr) {
+        s->getCostStats(stats);
+    } else {
+        stats = {};
+    }
+}
+
+uint64_t imuGetSampleCount(uint8_t sensor) {
+    ImuSampler* s = sampler(sensor);
+    return s != nullptr ? s->sampleCount() : 0;
+}
+
+bool imuGetSampleRing(ImuSampleRing& ring, uint8_t sensor) {
+    ImuSampler* s = sampler(sensor);
+    if (s == nullptr) {
+        return false;
+    }
+    s->getSampleRing(ring);
+    return true;
+}
+
+TaskHandle_t imuGetTaskHandle() {
+    return imuTaskHandle;
 }
@@ -2,25 +2,90 @@
 #define IMU_SAMPLER_H
 
 #include <Arduino.h>
+#include "vibration_metrics.h"
+#include "spectrum.h"
 
-// Vibration metrics computed from IMU samples
-struct VibrationMetrics {
-    float rms_g;       // Root mean square acceleration magnitude
-    float peak_g;      // Peak acceleration magnitude
-    float temp_c;      // IMU temperature (if available)
-    uint32_t timestamp; // Timestamp when metrics were computed
-    bool valid;        // True if metrics are valid
+// Cost of one sensor's sampling path, averaged over the samples since the
+// previous window closed (one hop, or one whole window in burst mode)
+struct ImuCostStats {
+    uint16_t rate_hz;        // Sensor sample rate
+    uint32_t read_us;        // IMU bus read per sample (accel + gyro together)
+    uint32_t process_ns;     // Storing one sample and updating the sliding statistics
+    uint32_t compute_us;     // Window close: metrics, FFT and fault classification (once per window length)
+    float budget_pct;        // Share of the hop's duration spent on the above
+    uint32_t max_rate_hz;    // Sample rate at which the budget would reach 100%
+    uint32_t missed;         // Due reads that returned no sample since boot (bus error, no new data)
+    uint32_t classify_us;    // Latest fault classification: features + inference
+    uint32_t classify_over_budget;  // Classifications over FAULT_CLASSIFY_BUDGET_US since boot
+    bool valid;
 };
 
-// Initialize and start the IMU sampling task
-// Creates a FreeRTOS task pinned to Core 1
+// Sensors: 0 is the internal MPU6886, then the external Grove-port
+// sensors enabled in config.h (IMU_EXT_*) that answered at startup. Each
+// has its own sampler (rate, window, hop, metrics, history, spectrum);
+// the functions below take the sensor index and default to the internal IMU.
+
+// Initialize the sensors and start the IMU sampling task
+// Creates one FreeRTOS task, pinned to Core 1, that reads every sensor
 void imuStartSampling();
 
+// Number of running sensors
+uint8_t imuGetSensorCount();
+
+// Sensor name used in telemetry and diagnostics ("" for an unknown index)
+const char* imuGetSensorName(uint8_t sensor);
+
+// Switch to burst sampling: one window read from the internal IMU's FIFO
+// every intervalMs, sleeping in between; external sensors pause
+// (0 = continuous polling, the default)
+void imuSetBurstInterval(uint32_t intervalMs);
+
+// Between bursts: millis() time the next burst starts
+// Returns false while a burst runs or outside burst mode
+bool imuGetNextBurst(uint32_t& atMs);
+
 // Get the latest computed vibration metrics
 // Returns true if valid metrics are available
-bool imuGetLatestMetrics(VibrationMetrics& metrics);
+bool imuGetLatestMetrics(VibrationMetrics& metrics, uint8_t sensor = 0);
+
+// Copy up to max windows with seq > afterSeq from the history ring
+// (the last IMU_HISTORY_WINDOWS windows, IMU_EXT_HISTORY_WINDOWS for
+// external sensors), oldest first. Windows overlap: one closes every hop
+// (every window in burst mode). Once the clock is synced they close on UTC
+// hop boundaries, so every UTC second ends a window on every device
+// Returns the number of windows copied
+size_t imuGetHistory(uint32_t afterSeq, VibrationMetrics* out, size_t max, uint8_t sensor = 0);
+
+// Sequence number of the newest window (0 before the first window)
+uint32_t imuGetLatestSeq(uint8_t sensor = 0);
+
+// Get the latest spectrum (computed once per IMU_WINDOW_SAMPLES, not
+// every hop; its seq is the window it was computed for)
+// Returns true if a spectrum is available
+bool imuGetLatestSpectrum(VibrationSpectrum& spectrum, uint8_t sensor = 0);
+
+// Get the sampling path cost for the latest window
+void imuGetCostStats(ImuCostStats& stats, uint8_t sensor = 0);
+
+// Get raw sample count since boot (64-bit: never wraps)
+uint64_t imuGetSampleCount(uint8_t sensor = 0);
+
+// Read-only view of a sensor's sample ring, for readers that must neither
+// copy nor lock it (live stream). Sample k (counting as imuGetSampleCount)
+// is at k % size until sample k + size overwrites it: read, then check
+// that imuGetSampleCount() is still below k + size.
+struct ImuSampleRing {
+    const float (*xyz)[3];    // Acceleration in g
+    const int64_t* timeUs;    // esp_timer time of each sample
+    uint32_t size;
+    uint16_t rateHz;
+};
+
+// Returns false for an unknown sensor
+bool imuGetSampleRing(ImuSampleRing& ring, uint8_t sensor = 0);
 
-// Get raw sample count (for debugging)
-uint32_t imuGetSampleCount();
+// Get the sampling task handle (for stack/CPU diagnostics)
+// Returns nullptr before imuStartSampling()
+TaskHandle_t imuGetTaskHandle();
 
 #endif // IMU_SAMPLER_H
@@ -0,0 +1,371 @@
+#include "live_stream.h"
+#include "config.h"
+#include "diagnostics.h"
+#include "imu_sampler.h"
+#include "power_manager.h"
+#include "wifi_manager.h"
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <esp_timer.h>
+#include <string.h>
+
+#define LIVE_VERSION        1
+#define LIVE_TYPE_DATA      1
+#define LIVE_TYPE_PONG      2
+#define LIVE_TYPE_HELLO     3
+#define LIVE_FLAG_RAW       0x01
+#define LIVE_HEADER_BYTES   16
+#define LIVE_HELLO_BYTES    (LIVE_HEADER_BYTES + 12)
+#define LIVE_DATA_BYTES     20    // Data packet fields between the header and the windows
+#define LIVE_WINDOW_BYTES   20
+#define LIVE_SAMPLE_BYTES   6
+#define LIVE_WINDOWS_MAX    4     // Windows per packet (one per hop is the steady state)
+
+// Send on every Nth hello poll, rounded so the rate never exceeds the cap
+#define LIVE_SEND_EVERY  ((1000 / LIVE_STREAM_RATE_HZ + LIVE_STREAM_POLL_MS - 1) / LIVE_STREAM_POLL_MS)
+
+#if LIVE_HEADER_BYTES + LIVE_DATA_BYTES + LIVE_WINDOWS_MAX * LIVE_WINDOW_BYTES + LIVE_SAMPLE_BYTES > LIVE_STREAM_PACKET_MAX
+#error "LIVE_STREAM_PACKET_MAX too small for one packet"
+#endif
+
+// Little-endian field writer over the packet buffer; callers size the
+// packet before writing, so there is no bounds check per field
+struct PacketWriter {
+    uint8_t* buf;
+    size_t len;
+
+    template <typename T>
+    void put(T value) {
+        memcpy(buf + len, &value, sizeof(value));
+        len += sizeof(value);
+    }
+};
+
+// Stream state; only the stream task touches it
+static WiFiUDP udp;
+static bool udpBound = false;
+static bool subscribed = false;
+static IPAddress receiverIp;
+static uint16_t receiverPort = 0;
+static unsigned long lastHelloTime = 0;
+static uint8_t streamSensor = 0;
+static bool streamRaw = false;
+static uint16_t decimation = LIVE_STREAM_DECIMATION;
+static uint64_t nextSample = 0;      // Oldest raw sample not yet sent
+static uint32_t lastWindowSeq = 0;   // Newest window sent
+static uint32_t dataSeq = 0;
+static uint8_t packet[LIVE_STREAM_PACKET_MAX];
+
+// Counters (guarded by statsMutex)
+static LiveStreamStats stats = {};
+static uint64_t sendUsTotal = 0;
+static SemaphoreHandle_t statsMutex = nullptr;
+static TaskHandle_t liveTaskHandle = nullptr;
+
+static void writeHeader(PacketWriter& w, uint8_t type, uint32_t seq) {
+    w.put<uint8_t>('V');
+    w.put<uint8_t>('L');
+    w.put<uint8_t>(LIVE_VERSION);
+    w.put<uint8_t>(type);
+    w.put<uint32_t>(seq);
+    w.put<int64_t>(0);   // sent_us, stamped by sendPacket()
+}
+
+static bool sendPacket(const IPAddress& ip, uint16_t port, size_t len) {
+    int64_t now = esp_timer_get_time();
+    memcpy(packet + 8, &now, sizeof(now));
+
+    return udp.beginPacket(ip, port) == 1 &&
+           udp.write(packet, len) == len &&
+           udp.endPacket() == 1;
+}
+
+static int16_t toMilliG(float g) {
+    float mg = g * 1000.0f;
+    if (mg > 32767.0f) return 32767;
+    if (mg < -32767.0f) return -32767;
+    return (int16_t)lroundf(mg);
+}
+
+// Raw samples averaged per sent sample: the request (or the default),
+// raised to stay under LIVE_STREAM_MAX_RAW_HZ, within half a ring
+static uint16_t chooseDecimation(uint16_t requested, const ImuSampleRing& ring) {
+    uint32_t dec = requested != 0 ? requested : LIVE_STREAM_DECIMATION;
+    uint32_t minDec = (ring.rateHz + LIVE_STREAM_MAX_RAW_HZ - 1) / LIVE_STREAM_MAX_RAW_HZ;
+    if (dec < minDec) dec = minDec;
+    if (dec > ring.size / 2) dec = ring.size / 2;
+    return dec > 0 ? (uint16_t)dec : 1;
+}
+
+// Take hellos: the sender becomes (or stays) the receiver, and each gets
+// a pong so the receiver can map device time to its own clock
+static void pollHellos() {
+    while (udp.parsePacket() > 0) {
+        int64_t rxUs = esp_timer_get_time();
+        uint8_t hello[LIVE_HELLO_BYTES];
+        if (udp.read(hello, sizeof(hello)) != LIVE_HELLO_BYTES ||
+            hello[0] != 'V' || hello[1] != 'L' || hello[2] != LIVE_VERSION || hello[3] != LIVE_TYPE_HELLO) {
+            continue;
+        }
+
+        uint8_t flags = hello[LIVE_HEADER_BYTES];
+        uint8_t sensor = hello[LIVE_HEADER_BYTES + 1];
+        uint16_t requestedDec;
+        uint64_t hostUs;
+        memcpy(&requestedDec, hello + LIVE_HEADER_BYTES + 2, sizeof(requestedDec));
+        memcpy(&hostUs, hello + LIVE_HEADER_BYTES + 4, sizeof(hostUs));
+
+        if (sensor >= imuGetSensorCount()) {
+            sensor = 0;
+        }
+        ImuSampleRing ring;
+        if (!imuGetSampleRing(ring, sensor)) {
+            continue;
+        }
+        bool raw = (flags & LIVE_FLAG_RAW) != 0;
+        uint16_t dec = chooseDecimation(requestedDec, ring);
+
+        // New receiver or new settings: start from the live edge
+        IPAddress ip = udp.remoteIP();
+        uint16_t port = udp.remotePort();
+        if (!subscribed || !(ip == receiverIp) || port != receiverPort ||
+            sensor != streamSensor || raw != streamRaw || dec != decimation) {
+            receiverIp = ip;
+            receiverPort = port;
+            streamSensor = sensor;
+            streamRaw = raw;
+            decimation = dec;
+            nextSample = imuGetSampleCount(sensor);
+            uint32_t latest = imuGetLatestSeq(sensor);
+            lastWindowSeq = latest > 0 ? latest - 1 : 0;
+            subscribed = true;
+            Serial.printf("Live stream: receiver %s:%u, sensor %s, raw %s (%u Hz)\n",
+                          ip.toString().c_str(), port, imuGetSensorName(sensor),
+                          raw ? "on" : "off", (unsigned)(ring.rateHz / dec));
+        }
+        lastHelloTime = millis();
+
+        PacketWriter w = {packet, 0};
+        writeHeader(w, LIVE_TYPE_PONG, 0);
+        w.put<uint64_t>(hostUs);
+        w.put<int64_t>(rxUs);
+        sendPacket(ip, port, w.len);
+    }
+}
+
+// One data packet: windows closed since the last one, and the raw samples
+// since the last one averaged in groups of `decimation`, read straight
+// from the sampler's ring
+static void sendData() {
+    int64_t startUs = esp_timer_get_time();
+
+    ImuSampleRing ring;
+    if (!imuGetSampleRing(ring, streamSensor)) {
+        return;
+    }
+
+    PacketWriter w = {packet, 0};
+    writeHeader(w, LIVE_TYPE_DATA, dataSeq);
+    size_t fieldsAt = w.len;
+    w.len += LIVE_DATA_BYTES;   // Filled in once the counts are known
+
+    VibrationMetrics windows[LIVE_WINDOWS_MAX];
+    size_t windowCount = imuGetHistory(lastWindowSeq, windows, LIVE_WINDOWS_MAX, streamSensor);
+    for (size_t i = 0; i < windowCount; i++) {
+        w.put<uint32_t>(windows[i].seq);
+        w.put<int64_t>(windows[i].window_us);
+        w.put<float>(windows[i].rms_g);
+        w.put<float>(windows[i].peak_g);
+    }
+    if (windowCount > 0) {
+        lastWindowSeq = windows[windowCount - 1].seq;
+    }
+
+    uint32_t overruns = 0;
+    uint16_t sampleCount = 0;
+    int64_t firstUs = 0;
+    if (streamRaw) {
+        // More than half a ring behind: skip ahead rather than race the writer
+        uint64_t available = imuGetSampleCount(streamSensor);
+        uint64_t backlog = available - nextSample;
+        if (backlog > ring.size / 2) {
+            uint32_t skip = (uint32_t)((backlog - ring.size / 2 + decimation - 1) / decimation * decimation);
+            nextSample += skip;
+            overruns += skip;
+        }
+
+        uint32_t groups = (uint32_t)((available - nextSample) / decimation);
+        uint32_t room = (LIVE_STREAM_PACKET_MAX - w.len) / LIVE_SAMPLE_BYTES;
+        if (groups > room) {
+            groups = room;
+        }
+
+        size_t samplesAt = w.len;
+        uint64_t k = nextSample;
+        uint32_t slot = (uint32_t)(k % ring.size);
+        for (uint32_t g = 0; g < groups; g++) {
+            float sum[3] = {};
+            uint32_t first = slot;
+            for (uint32_t d = 0; d < decimation; d++) {
+                const float* s = ring.xyz[slot];
+                sum[0] += s[0];
+                sum[1] += s[1];
+                sum[2] += s[2];
+                if (d + 1 < decimation && ++slot == ring.size) {
+                    slot = 0;
+                }
+            }
+            if (g == 0) {
+                // Group centre time
+                firstUs = (ring.timeUs[first] + ring.timeUs[slot]) / 2;
+            }
+            if (++slot == ring.size) {
+                slot = 0;
+            }
+            for (int axis = 0; axis < 3; axis++) {
+                w.put<int16_t>(toMilliG(sum[axis] / decimation));
+            }
+            k += decimation;
+        }
+
+        // A sample the sampler overwrote while we read it is torn; drop them all
+        if (imuGetSampleCount(streamSensor) - nextSample >= ring.size) {
+            overruns += (uint32_t)(k - nextSample);
+            w.len = samplesAt;
+        } else {
+            sampleCount = (uint16_t)groups;
+        }
+        nextSample = k;
+    }
+
+    if (windowCount == 0 && sampleCount == 0) {
+        if (overruns > 0 && xSemaphoreTake(statsMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+            stats.overruns += overruns;
+            xSemaphoreGive(statsMutex);
+        }
+        return;
+    }
+
+    uint32_t totalOverruns = stats.overruns + overruns;
+    PacketWriter fields = {packet, fieldsAt};
+    fields.put<uint8_t>(streamSensor);
+    fields.put<uint8_t>((uint8_t)windowCount);
+    fields.put<uint16_t>(sampleCount);
+    fields.put<int64_t>(firstUs);
+    fields.put<uint32_t>((uint32_t)decimation * 1000000 / ring.rateHz);
+    fields.put<uint32_t>(totalOverruns);
+
+    bool sent = sendPacket(receiverIp, receiverPort, w.len);
+    dataSeq++;
+
+    if (xSemaphoreTake(statsMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        stats.overruns = totalOverruns;
+        if (sent) {
+            stats.packets++;
+            stats.bytes += w.len;
+            stats.samples += sampleCount;
+            sendUsTotal += esp_timer_get_time() - startUs;
+        } else {
+            stats.send_errors++;
+        }
+        xSemaphoreGive(statsMutex);
+    }
+}
+
+static void liveStreamTask(void* param) {
+    TickType_t lastWake = xTaskGetTickCount();
+    const TickType_t period = pdMS_TO_TICKS(LIVE_STREAM_POLL_MS);
+    uint32_t tick = 0;
+
+    while (true) {
+        vTaskDelayUntil(&lastWake, period);
+
+        if (!wifiIsConnected()) {
+            if (udpBound) {
+                udp.stop();
+                udpBound = false;
+            }
+            subscribed = false;
+            continue;
+        }
+        if (!udpBound) {
+            udpBound = udp.begin(LIVE_STREAM_PORT) == 1;
+            if (!udpBound) {
+                continue;
+            }
+        }
+
+        pollHellos();
+
+        if (subscribed && millis() - lastHelloTime > LIVE_STREAM_LEASE_MS) {
+            subscribed = false;
+            Serial.println("Live stream: receiver lease expired");
+        }
+
+        if (subscribed && ++tick % LIVE_SEND_EVERY == 0) {
+            sendData();
+        }
+    }
+}
+
+#if LIVE_STREAM_ENABLED
+// Diagnostics "live" section: counters since boot
+static void writeDiagSection(JsonVariant section) {
+    LiveStreamStats liveStats;
+    liveStreamGetStats(liveStats);
+    JsonObject live = section.to<JsonObject>();
+    live["subscribed"] = liveStats.subscribed;
+    live["packets"] = liveStats.packets;
+    live["bytes"] = liveStats.bytes;
+    live["samples"] = liveStats.samples;
+    live["overruns"] = liveStats.overruns;
+    live["send_errors"] = liveStats.send_errors;
+    live["send_us"] = liveStats.send_us;
+}
+#endif
+
+void liveStreamInit() {
+#if LIVE_STREAM_ENABLED
+    diagRegisterSection("live", writeDiagSection);
+
+    // Modem sleep and light sleep would add hundreds of ms per packet
+    if (powerIsDutyCycled()) {
+        Serial.println("WARNING: Live stream is not available in the duty-cycled power profile");
+        return;
+    }
+
+    statsMutex = xSemaphoreCreateMutex();
+    if (statsMutex == nullptr) {
+        Serial.println("ERROR: Failed to create live stream mutex");
+        return;
+    }
+
+    BaseType_t result = xTaskCreatePinnedToCore(
+        liveStreamTask,
+        "live_stream",
+        LIVE_STREAM_TASK_STACK_SIZE,
+        nullptr,
+        LIVE_STREAM_TASK_PRIORITY,
+        &liveTaskHandle,
+        LIVE_STREAM_TASK_CORE
+    );
+
+    if (result != pdPASS) {
+        Serial.println("ERROR: Failed to create live stream task");
+        return;
+    }
+
+    Serial.printf("Live stream: listening on UDP port %d\n", LIVE_STREAM_PORT);
+#endif
+}
+
+void liveStreamGetStats(LiveStreamStats& out) {
+    out = {};
+
+    if (statsMutex != nullptr && xSemaphoreTake(statsMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
+        out = stats;
+        out.subscribed = subscribed;
+        out.send_us = stats.packets > 0 ? (uint32_t)(sendUsTotal / stats.packets) : 0;
+        xSemaphoreGive(statsMutex);
+    }
+}
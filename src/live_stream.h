@@ -0,0 +1,43 @@
+#ifndef LIVE_STREAM_H
+#define LIVE_STREAM_H
+
+#include <Arduino.h>
+
+// LAN live stream for commissioning (mounting a sensor, balancing a
+// rotor): per-window metrics and decimated raw samples of one sensor,
+// sent over UDP at up to LIVE_STREAM_RATE_HZ packets per second to the
+// receiver that last sent a hello (extras/live_receiver). Independent of
+// the MQTT path; raw samples are read in place from the sampler's ring
+// without taking its lock.
+//
+// Datagrams are little-endian and start with a 16-byte header:
+//   "VL", version (1), type, seq (u32), sent_us (i64, device esp_timer)
+// Receiver -> device, type 3 (hello, renews the lease):
+//   flags (u8, bit 0 = raw samples), sensor (u8), decimation (u16, 0 = default), host_us (u64)
+// Device -> receiver, type 2 (pong, sent on each hello):
+//   host_us (u64, echoed), rx_us (i64, device time the hello was read)
+// Device -> receiver, type 1 (data):
+//   sensor (u8), windows (u8), samples (u16), first_us (i64), period_us (u32), overruns (u32),
+//   windows x {seq (u32), close_us (i64), rms_g (f32), peak_g (f32)},
+//   samples x {x, y, z (i16, mg)}
+// Device times are esp_timer microseconds; the receiver maps them to its
+// own clock from the pongs.
+
+struct LiveStreamStats {
+    bool subscribed;         // A receiver's lease is current
+    uint32_t packets;        // Data packets sent since boot
+    uint32_t bytes;          // Data bytes sent since boot
+    uint32_t samples;        // Raw samples sent (after decimation)
+    uint32_t overruns;       // Raw samples overwritten in the ring before they were sent
+    uint32_t send_errors;
+    uint32_t send_us;        // Mean time building and sending a data packet
+};
+
+// Start the live stream task if LIVE_STREAM_ENABLED (call after WiFi is up
+// and the power profile is applied; the duty-cycled profile has no stream)
+void liveStreamInit();
+
+// Get stream counters since boot
+void liveStreamGetStats(LiveStreamStats& stats);
+
+#endif // LIVE_STREAM_H
@@ -5,10 +5,23 @@
 #include "imu_sampler.h"
 #include "telemetry.h"
 #include "display_ui.h"
+#include "diagnostics.h"
+#include "power_manager.h"
+#include "mem_arena.h"
+#include "live_stream.h"
 
 // Timing variables
 static unsigned long lastTelemetryTime = 0;
 static unsigned long lastDisplayTime = 0;
+static unsigned long lastDiagSampleTime = 0;
+static unsigned long lastDiagPublishTime = 0;
+static unsigned long lastUploadTime = 0;
+static unsigned long lastAwsRetryTime = 0;
+
+// Duty cycle: batched upload resumed from loop() while PUBACKs free slots
+static bool uploadActive = false;
+static unsigned long uploadStartTime = 0;
+static uint32_t uploadWindows = 0;
 
 // State tracking
 static bool awsInitialized = false;
@@ -28,7 +41,10 @@ void setup() {
     Serial.println("  M5Stack Core2 AWS + AWS IoT Core");
     Serial.println("========================================\n");
 
-    // Initialize display
+    // Reserve PSRAM arenas before any module allocates its buffers
+    memInit();
+
+    // Initialize display (starts the display task)
     displayInit();
     displayDrawStatusScreen();
 
@@ -36,8 +52,7 @@ void setup() {
     Serial.println("Initializing secure element...");
     if (!awsInitSecureElement()) {
         Serial.println("FATAL: Secure element init failed!");
-        M5.Lcd.setTextColor(TFT_RED);
-        M5.Lcd.drawString("ATECC608 INIT FAILED", 10, 100);
+        displayShowError("ATECC608 INIT FAILED");
         while (1) delay(1000);
     }
 
@@ -47,8 +62,7 @@ void setup() {
 
     if (!wifiConnect()) {
         Serial.println("FATAL: WiFi connection failed!");
-        M5.Lcd.setTextColor(TFT_RED);
-        M5.Lcd.drawString("WIFI CONNECT FAILED", 10, 100);
+        displayShowError("WIFI CONNECT FAILED");
         while (1) delay(1000);
     }
 
@@ -65,10 +79,19 @@ void setup() {
 
     displayUpdate();
 
+    // Start firmware self-profiling
+    diagInit();
+
+    // Apply the power profile (burst sampling, modem sleep, coulomb counter)
+    powerInit();
+
     // Start IMU sampling task
     Serial.println("Starting IMU sampling...");
     imuStartSampling();
 
+    // LAN live stream for commissioning (if enabled in config.h)
+    liveStreamInit();
+
     // Initial display update
     displayDrawStatusScreen();
 
@@ -76,18 +99,30 @@ void setup() {
 }
 
 void loop() {
+    diagLoopBegin();
+
     // Update M5Stack (buttons, touch, etc.)
     M5.update();
 
+    // Any touch counts as activity; a touch that wakes the display is consumed
+    bool wokeDisplay = M5.Touch.getCount() > 0 && powerNoteActivity();
+
+    // Middle touch button cycles through screens
+    if (!wokeDisplay && M5.BtnB.wasPressed()) {
+        displayNextScreen();
+    }
+
     // Maintain WiFi connection
     wifiMaintain();
 
     // Maintain MQTT connection
     awsMaintain();
 
-    // Handle AWS reconnection if needed
+    // Handle AWS reconnection if needed (immediately after a drop, then
+    // every WIFI_RETRY_DELAY_MS)
     if (wifiIsConnected() && !awsIsConnected()) {
-        if (awsConnectedState || !awsInitialized) {
+        if (awsConnectedState || !awsInitialized || millis() - lastAwsRetryTime >= WIFI_RETRY_DELAY_MS) {
+            lastAwsRetryTime = millis();
             Serial.println("AWS IoT disconnected, attempting reconnect...");
             if (awsConnect()) {
                 awsConnectedState = true;
@@ -102,9 +137,45 @@ void loop() {
         awsInitialized = true;
     }
 
-    // Publish telemetry at configured interval
+    // Display timeout, modem sleep, energy accounting
+    powerMaintain();
+
     unsigned long now = millis();
-    if (now - lastTelemetryTime >= TELEMETRY_INTERVAL_MS) {
+
+    // Duty cycle: upload all new windows (and diagnostics) in one batch
+    if (powerIsDutyCycled()) {
+        if (now - lastUploadTime >= POWER_UPLOAD_INTERVAL_MS) {
+            lastUploadTime = now;
+
+            // Windows stay in history for the next upload if this one is missed
+            if (awsIsConnected()) {
+                uploadActive = true;
+                uploadStartTime = now;
+                uploadWindows = 0;
+
+                if (!diagPublish()) {
+                    Serial.println("Diagnostics publish failed");
+                }
+            } else {
+                Serial.println("Skipping batched upload - not connected to AWS IoT");
+            }
+        }
+
+        // A backlog fills the in-flight window; each pass of the loop picks
+        // up PUBACKs in awsMaintain() and sends as much as the window allows
+        if (uploadActive) {
+            powerBeginUpload();
+            uploadWindows += telemetryPublishBatch();
+
+            bool timedOut = now - uploadStartTime >= POWER_UPLOAD_MAX_MS;
+            if (!telemetryBatchPending() || timedOut || !awsIsConnected()) {
+                uploadActive = false;
+                Serial.printf("Batched upload: %lu windows%s\n", (unsigned long)uploadWindows,
+                              telemetryBatchPending() ? " (rest waits for the next upload)" : "");
+            }
+        }
+    } else if (now - lastTelemetryTime >= TELEMETRY_INTERVAL_MS) {
+        // Continuous: publish the latest window at configured interval
         lastTelemetryTime = now;
 
         if (awsIsConnected()) {
@@ -118,12 +189,30 @@ void loop() {
         }
     }
 
-    // Update display at configured interval
+    // Sample and publish diagnostics at a much lower rate than telemetry
+    if (now - lastDiagSampleTime >= DIAG_SAMPLE_INTERVAL_MS) {
+        lastDiagSampleTime = now;
+        diagSample();
+    }
+
+    if (!powerIsDutyCycled() && now - lastDiagPublishTime >= DIAG_PUBLISH_INTERVAL_MS) {
+        lastDiagPublishTime = now;
+
+        if (awsIsConnected() && !diagPublish()) {
+            Serial.println("Diagnostics publish failed");
+        }
+    }
+
+    // Hand status to the display task at configured interval
     if (now - lastDisplayTime >= DISPLAY_UPDATE_INTERVAL_MS) {
         lastDisplayTime = now;
         displayUpdate();
     }
 
-    // Small delay to prevent tight loop
-    delay(10);
+    diagLoopEnd();
+
+    // Small delay to prevent tight loop; duty-cycled, light sleep until
+    // the next burst or upload
+    unsigned long sinceUpload = millis() - lastUploadTime;
+    powerIdle(sinceUpload < POWER_UPLOAD_INTERVAL_MS ? POWER_UPLOAD_INTERVAL_MS - sinceUpload : 0);
 }
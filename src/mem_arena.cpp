@@ -0,0 +1,177 @@
+#include "mem_arena.h"
+#include "config.h"
+#include <esp_heap_caps.h>
+
+#define ARENA_ALIGN 16
+
+struct Arena {
+    const char* name;
+    uint8_t* base;
+    size_t capacity;
+    size_t used;
+    size_t peak;
+    uint32_t failures;
+    bool psram;
+};
+
+static Arena arenas[ARENA_COUNT] = {
+    {"imu", nullptr, MEM_ARENA_IMU_KB * 1024, 0, 0, 0, false},
+    {"display", nullptr, MEM_ARENA_DISPLAY_KB * 1024, 0, 0, 0, false},
+    {"json", nullptr, MEM_ARENA_JSON_KB * 1024, 0, 0, 0, false},
+};
+
+// Allocations from ARENA_JSON still alive; the arena rewinds when this is 0
+static uint32_t jsonLive = 0;
+
+// Modules reserve their buffers from their own init paths and tasks
+static portMUX_TYPE arenaLock = portMUX_INITIALIZER_UNLOCKED;
+
+static size_t alignUp(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static void* bump(Arena& a, size_t size) {
+    size = alignUp(size);
+
+    void* ptr = nullptr;
+    portENTER_CRITICAL(&arenaLock);
+    if (a.base != nullptr && a.capacity - a.used >= size) {
+        ptr = a.base + a.used;
+        a.used += size;
+        if (a.used > a.peak) {
+            a.peak = a.used;
+        }
+    } else {
+        a.failures++;
+    }
+    portEXIT_CRITICAL(&arenaLock);
+
+    return ptr;
+}
+
+void memInit() {
+    for (int i = 0; i < ARENA_COUNT; i++) {
+        Arena& a = arenas[i];
+
+        a.base = (uint8_t*)heap_caps_aligned_alloc(ARENA_ALIGN, a.capacity, MALLOC_CAP_SPIRAM);
+        a.psram = a.base != nullptr;
+        if (a.base == nullptr) {
+            a.base = (uint8_t*)heap_caps_aligned_alloc(ARENA_ALIGN, a.capacity, MALLOC_CAP_8BIT);
+        }
+
+        if (a.base == nullptr) {
+            Serial.printf("ERROR: Failed to reserve %s arena (%u KB)\n", a.name, (unsigned)(a.capacity / 1024));
+            a.capacity = 0;
+        } else if (!a.psram) {
+            Serial.printf("WARNING: %s arena in internal RAM (no PSRAM)\n", a.name);
+        }
+    }
+
+    Serial.printf("Memory arenas: imu %u KB, display %u KB, json %u KB\n",
+                  MEM_ARENA_IMU_KB, MEM_ARENA_DISPLAY_KB, MEM_ARENA_JSON_KB);
+}
+
+void* memArenaAlloc(MemArena arena, size_t size) {
+    return bump(arenas[arena], size);
+}
+
+// JSON blocks carry their size in front so reallocate can copy them
+struct JsonBlockHeader {
+    size_t size;
+    uint8_t pad[ARENA_ALIGN - sizeof(size_t)];
+};
+
+static bool inJsonArena(void* ptr) {
+    const Arena& a = arenas[ARENA_JSON];
+    return a.base != nullptr && (uint8_t*)ptr >= a.base && (uint8_t*)ptr < a.base + a.capacity;
+}
+
+// Documents are short-lived (built, serialized, dropped), so a bump
+// pointer that rewinds when the last one is freed never fragments.
+// Requests that do not fit spill to the general heap. Changes to the
+// arena's use take the lock, like bump(), since diagnostics reads it.
+class ArenaJsonAllocator : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override {
+        JsonBlockHeader* h = (JsonBlockHeader*)bump(arenas[ARENA_JSON], sizeof(JsonBlockHeader) + size);
+        if (h == nullptr) {
+            return malloc(size);
+        }
+        h->size = size;
+        portENTER_CRITICAL(&arenaLock);
+        jsonLive++;
+        portEXIT_CRITICAL(&arenaLock);
+        return h + 1;
+    }
+
+    void deallocate(void* ptr) override {
+        if (!inJsonArena(ptr)) {
+            free(ptr);
+            return;
+        }
+
+        portENTER_CRITICAL(&arenaLock);
+        if (--jsonLive == 0) {
+            arenas[ARENA_JSON].used = 0;
+        }
+        portEXIT_CRITICAL(&arenaLock);
+    }
+
+    void* reallocate(void* ptr, size_t newSize) override {
+        if (!inJsonArena(ptr)) {
+            return realloc(ptr, newSize);
+        }
+
+        Arena& a = arenas[ARENA_JSON];
+        JsonBlockHeader* h = (JsonBlockHeader*)ptr - 1;
+
+        // The newest block can grow or shrink in place
+        uint8_t* end = (uint8_t*)ptr + alignUp(h->size);
+        size_t start = (uint8_t*)ptr - a.base;
+        bool inPlace = false;
+        portENTER_CRITICAL(&arenaLock);
+        if (end == a.base + a.used && start + alignUp(newSize) <= a.capacity) {
+            a.used = start + alignUp(newSize);
+            if (a.used > a.peak) {
+                a.peak = a.used;
+            }
+            inPlace = true;
+        }
+        portEXIT_CRITICAL(&arenaLock);
+        if (inPlace) {
+            h->size = newSize;
+            return ptr;
+        }
+
+        if (newSize <= h->size) {
+            h->size = newSize;
+            return ptr;
+        }
+
+        void* moved = allocate(newSize);
+        if (moved != nullptr) {
+            memcpy(moved, ptr, h->size);
+            deallocate(ptr);
+        }
+        return moved;
+    }
+};
+
+static ArenaJsonAllocator jsonAllocator;
+
+ArduinoJson::Allocator* memJsonAllocator() {
+    return &jsonAllocator;
+}
+
+void memGetArenaStats(MemArena arena, MemArenaStats& stats) {
+    const Arena& a = arenas[arena];
+
+    portENTER_CRITICAL(&arenaLock);
+    stats.name = a.name;
+    stats.capacity = a.capacity;
+    stats.used = a.used;
+    stats.peak = a.peak;
+    stats.failures = a.failures;
+    stats.psram = a.psram;
+    portEXIT_CRITICAL(&arenaLock);
+}
@@ -0,0 +1,43 @@
+#ifndef MEM_ARENA_H
+#define MEM_ARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Memory placement. Big, sequentially accessed buffers are carved from
+// arenas reserved once at boot in PSRAM, so they neither fragment the
+// internal heap nor compete with WiFi/TLS for it. Small, hot data (FFT
+// work buffers, mutexes, task stacks, MQTT state) stays in internal RAM
+// as ordinary statics. Without PSRAM the arenas fall back to internal RAM.
+enum MemArena {
+    ARENA_IMU = 0,      // Sample window and window history (offline backlog)
+    ARENA_DISPLAY,      // Shown-frame copy for the dirty-tile diff
+    ARENA_JSON,         // ArduinoJson documents, reset when none are alive
+    ARENA_COUNT
+};
+
+// Usage of one arena
+struct MemArenaStats {
+    const char* name;
+    uint32_t capacity;     // Bytes reserved at boot
+    uint32_t used;         // Bytes handed out now
+    uint32_t peak;         // Highest use since boot
+    uint32_t failures;     // Requests that did not fit (JSON: spilled to the heap)
+    bool psram;            // false if the arena fell back to internal RAM
+};
+
+// Reserve the arenas (call first in setup, before any module allocates)
+void memInit();
+
+// Allocate a buffer that lives until reboot, 16-byte aligned
+// Returns nullptr if the arena is full
+void* memArenaAlloc(MemArena arena, size_t size);
+
+// Allocator for JsonDocument, backed by ARENA_JSON
+// Use from the loop task only
+ArduinoJson::Allocator* memJsonAllocator();
+
+// Get usage for one arena
+void memGetArenaStats(MemArena arena, MemArenaStats& stats);
+
+#endif // MEM_ARENA_H
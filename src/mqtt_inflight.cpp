@@ -0,0 +1,197 @@
+#include "mqtt_inflight.h"
+#include <string.h>
+
+// MQTT control packet types (upper nibble of the fixed header)
+#define MQTT_TYPE_PUBLISH  3
+#define MQTT_TYPE_PUBACK   4
+
+void MqttPacketScanner::reset() {
+    _state = STATE_HEADER;
+    _type = 0;
+    _qos = 0;
+    _remaining = 0;
+    _multiplier = 1;
+    _topicLen = 0;
+    _packetId = 0;
+}
+
+MqttPacketScanner::Event MqttPacketScanner::feed(uint8_t b) {
+    Event event = EVENT_NONE;
+
+    switch (_state) {
+        case STATE_HEADER:
+            _type = b >> 4;
+            _qos = (b >> 1) & 0x03;
+            _remaining = 0;
+            _multiplier = 1;
+            _state = STATE_LENGTH;
+            return EVENT_NONE;
+
+        case STATE_LENGTH:
+            // Remaining length: up to 4 bytes, 7 bits each, LSB first
+            _remaining += (b & 0x7F) * _multiplier;
+            _multiplier *= 128;
+            if (b & 0x80) {
+                if (_multiplier > 128UL * 128 * 128) {
+                    reset();  // Malformed length, resync on next byte
+                }
+                return EVENT_NONE;
+            }
+
+            if (_remaining == 0) {
+                _state = STATE_HEADER;
+            } else if (_type == MQTT_TYPE_PUBLISH) {
+                _state = STATE_TOPIC_LEN_HI;
+            } else if (_type == MQTT_TYPE_PUBACK) {
+                _state = STATE_ID_HI;
+            } else {
+                _state = STATE_SKIP;
+            }
+            return EVENT_NONE;
+
+        default:
+            break;
+    }
+
+    // Variable header / payload bytes
+    _remaining--;
+
+    switch (_state) {
+        case STATE_TOPIC_LEN_HI:
+            _topicLen = (uint16_t)b << 8;
+            _state = STATE_TOPIC_LEN_LO;
+            break;
+
+        case STATE_TOPIC_LEN_LO:
+            _topicLen |= b;
+            if (_topicLen > 0) {
+                _state = STATE_TOPIC;
+            } else {
+                _state = _qos > 0 ? STATE_ID_HI : STATE_SKIP;
+            }
+            break;
+
+        case STATE_TOPIC:
+            if (--_topicLen == 0) {
+                // QoS 0 publishes carry no packet id
+                _state = _qos > 0 ? STATE_ID_HI : STATE_SKIP;
+            }
+            break;
+
+        case STATE_ID_HI:
+            _packetId = (uint16_t)b << 8;
+            _state = STATE_ID_LO;
+            break;
+
+        case STATE_ID_LO:
+            _packetId |= b;
+            event = (_type == MQTT_TYPE_PUBLISH) ? EVENT_PUBLISH : EVENT_PUBACK;
+            _state = STATE_SKIP;
+            break;
+
+        default:
+            break;
+    }
+
+    if (_remaining == 0) {
+        _state = STATE_HEADER;
+    }
+
+    return event;
+}
+
+MqttInflightWindow::MqttInflightWindow() : _nextSequence(0) {
+    memset(_slots, 0, sizeof(_slots));
+    memset(_sequence, 0, sizeof(_sequence));
+}
+
+int MqttInflightWindow::reserve(const char* topic, const char* payload, size_t length, int64_t originUs) {
+    size_t topicLen = strlen(topic);
+    if (topicLen >= MQTT_INFLIGHT_TOPIC_MAX || length > MQTT_INFLIGHT_PAYLOAD_MAX) {
+        return -1;
+    }
+
+    for (int i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+        MqttInflightSlot& s = _slots[i];
+        if (s.state != SLOT_FREE) {
+            continue;
+        }
+
+        memcpy(s.topic, topic, topicLen + 1);
+        memcpy(s.payload, payload, length);
+        s.length = (uint16_t)length;
+        s.packetId = 0;
+        s.sendCount = 0;
+        s.originUs = originUs;
+        s.sentUs = 0;
+        s.state = SLOT_UNSENT;
+        _sequence[i] = _nextSequence++;
+        return i;
+    }
+
+    return -1;
+}
+
+void MqttInflightWindow::markSent(int slot, uint16_t packetId, int64_t nowUs) {
+    MqttInflightSlot& s = _slots[slot];
+    s.packetId = packetId;
+    s.sentUs = nowUs;
+    s.sendCount++;
+    s.state = SLOT_AWAITING_ACK;
+}
+
+int MqttInflightWindow::findAcked(uint16_t packetId) const {
+    for (int i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+        if (_slots[i].state == SLOT_AWAITING_ACK && _slots[i].packetId == packetId) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void MqttInflightWindow::release(int slot) {
+    _slots[slot].state = SLOT_FREE;
+}
+
+void MqttInflightWindow::requeueAll() {
+    for (int i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+        if (_slots[i].state == SLOT_AWAITING_ACK) {
+            _slots[i].state = SLOT_UNSENT;
+        }
+    }
+}
+
+int MqttInflightWindow::requeueExpired(int64_t nowUs, int64_t timeoutUs) {
+    int count = 0;
+    for (int i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+        if (_slots[i].state == SLOT_AWAITING_ACK && nowUs - _slots[i].sentUs > timeoutUs) {
+            _slots[i].state = SLOT_UNSENT;
+            count++;
+        }
+    }
+    return count;
+}
+
+int MqttInflightWindow::nextUnsent() const {
+    int oldest = -1;
+    for (int i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+        if (_slots[i].state != SLOT_UNSENT) {
+            continue;
+        }
+        // Sequence distance handles counter wraparound
+        if (oldest < 0 || (int32_t)(_sequence[i] - _sequence[oldest]) < 0) {
+            oldest = i;
+        }
+    }
+    return oldest;
+}
+
+uint8_t MqttInflightWindow::inFlight() const {
+    uint8_t count = 0;
+    for (int i = 0; i < MQTT_INFLIGHT_WINDOW; i++) {
+        if (_slots[i].state != SLOT_FREE) {
+            count++;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,115 @@
+#ifndef MQTT_INFLIGHT_H
+#define MQTT_INFLIGHT_H
+
+// Portable (no Arduino dependencies) so the host-side tools can share it
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// Incremental MQTT 3.1.1 packet scanner
+// Fed one direction of a byte stream, it reports the packet id of every
+// QoS > 0 PUBLISH and every PUBACK without buffering the packets
+class MqttPacketScanner {
+public:
+    enum Event {
+        EVENT_NONE = 0,
+        EVENT_PUBLISH,   // Outgoing/incoming QoS > 0 PUBLISH packet id decoded
+        EVENT_PUBACK     // PUBACK packet id decoded
+    };
+
+    MqttPacketScanner() { reset(); }
+
+    // Resynchronize on a packet boundary (call on every new connection)
+    void reset();
+
+    // Feed one byte of the stream
+    // Returns an event when a packet id has just been decoded
+    Event feed(uint8_t b);
+
+    // Packet id of the last EVENT_PUBLISH / EVENT_PUBACK
+    uint16_t packetId() const { return _packetId; }
+
+private:
+    enum State {
+        STATE_HEADER,
+        STATE_LENGTH,
+        STATE_TOPIC_LEN_HI,
+        STATE_TOPIC_LEN_LO,
+        STATE_TOPIC,
+        STATE_ID_HI,
+        STATE_ID_LO,
+        STATE_SKIP
+    };
+
+    State _state;
+    uint8_t _type;
+    uint8_t _qos;
+    uint32_t _remaining;
+    uint32_t _multiplier;
+    uint16_t _topicLen;
+    uint16_t _packetId;
+};
+
+// One buffered QoS 1 publish, kept until its PUBACK arrives
+struct MqttInflightSlot {
+    uint8_t state;                            // MqttInflightWindow::SlotState
+    uint16_t packetId;                        // Assigned when written to the socket
+    uint16_t length;                          // Payload length
+    uint8_t sendCount;                        // 1 = first attempt, >1 = retransmitted
+    int64_t originUs;                         // Caller timestamp (e.g. window close)
+    int64_t sentUs;                           // When last written to the socket
+    char topic[MQTT_INFLIGHT_TOPIC_MAX];
+    char payload[MQTT_INFLIGHT_PAYLOAD_MAX];
+};
+
+// Bounded window of unacknowledged QoS 1 publishes
+// Several publishes may be outstanding at once (no stop-and-wait); a
+// slot is released only when the broker's PUBACK for it arrives
+class MqttInflightWindow {
+public:
+    enum SlotState {
+        SLOT_FREE = 0,
+        SLOT_UNSENT,          // Buffered, not (or no longer) on the wire
+        SLOT_AWAITING_ACK     // Written, waiting for PUBACK
+    };
+
+    MqttInflightWindow();
+
+    // Copy a message into a free slot
+    // Returns the slot index, or -1 if the window is full or the
+    // message does not fit in a slot
+    int reserve(const char* topic, const char* payload, size_t length, int64_t originUs);
+
+    // Record the packet id a slot went out with
+    void markSent(int slot, uint16_t packetId, int64_t nowUs);
+
+    // Find the slot waiting for this PUBACK
+    // Returns the slot index (still occupied, call release()) or -1
+    int findAcked(uint16_t packetId) const;
+
+    // Free a slot
+    void release(int slot);
+
+    // Connection lost: everything on the wire must be sent again
+    void requeueAll();
+
+    // Requeue publishes whose PUBACK is overdue
+    // Returns the number of slots requeued
+    int requeueExpired(int64_t nowUs, int64_t timeoutUs);
+
+    // Next slot waiting to be (re)sent, oldest first, or -1
+    int nextUnsent() const;
+
+    // Number of occupied slots
+    uint8_t inFlight() const;
+
+    const MqttInflightSlot& slot(int i) const { return _slots[i]; }
+
+private:
+    MqttInflightSlot _slots[MQTT_INFLIGHT_WINDOW];
+    uint32_t _sequence[MQTT_INFLIGHT_WINDOW];   // Reservation order for FIFO resend
+    uint32_t _nextSequence;
+};
+
+#endif // MQTT_INFLIGHT_H
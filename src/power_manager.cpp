@@ -0,0 +1,313 @@
+#include "power_manager.h"
+#include "aws_iot.h"
+#include "config.h"
+#include "diagnostics.h"
+#include "display_ui.h"
+#include "imu_sampler.h"
+#include "wifi_manager.h"
+#include <M5Unified.h>
+#include <driver/gpio.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+
+// Automatic light sleep needs power management and tickless idle in the
+// framework build (the stock Arduino core has neither); without them
+// powerIdle() light-sleeps explicitly
+#define POWER_HAS_PM          (CONFIG_PM_ENABLE == 1)
+#define POWER_HAS_LIGHT_SLEEP (POWER_HAS_PM && CONFIG_FREERTOS_USE_TICKLESS_IDLE == 1)
+
+// AXP192 coulomb counter registers
+#define AXP192_ADC_RATE        0x84   // Bits 7:6 select 25/50/100/200 Hz
+#define AXP192_COULOMB_CHARGE  0xB0   // 32-bit big-endian, 0xB4 discharge follows
+#define AXP192_COULOMB_CTRL    0xB8
+#define AXP192_COULOMB_ENABLE  0x80
+#define AXP192_COULOMB_CLEAR   0x20
+
+// Profile state
+static bool dutyCycled = false;
+static bool autoLightSleep = false;
+
+// Display power (duty cycle only)
+static bool displayOn = true;
+static uint8_t displayBrightness = 0;
+static unsigned long lastActivityTime = 0;
+
+// Radio power save: modem sleep except right after an upload
+static unsigned long uploadAwakeUntil = 0;
+static bool uploadAwake = false;
+static bool modemSleepApplied = false;
+static bool wifiWasConnected = false;
+
+// Explicit light sleep: radio off between uploads
+static bool radioOn = true;
+static unsigned long radioOnSince = 0;
+static uint64_t sleptUs = 0;
+
+// Energy accounting
+static bool coulombValid = false;
+static float lastCoulombMah = 0;
+static float batteryMah = 0;
+static float energyJ = 0;
+static uint32_t windowsPublished = 0;
+static unsigned long lastSampleTime = 0;
+static unsigned long countStartTime = 0;
+
+// Net charge drawn from the battery since the counter was cleared
+static bool readCoulombMah(float& mah) {
+    uint8_t raw[8];
+    if (!M5.Power.Axp192.readRegister(AXP192_COULOMB_CHARGE, raw, sizeof(raw))) {
+        return false;
+    }
+
+    uint32_t charge = ((uint32_t)raw[0] << 24) | ((uint32_t)raw[1] << 16) | ((uint32_t)raw[2] << 8) | raw[3];
+    uint32_t discharge = ((uint32_t)raw[4] << 24) | ((uint32_t)raw[5] << 16) | ((uint32_t)raw[6] << 8) | raw[7];
+    int rateHz = 25 << (M5.Power.Axp192.readRegister8(AXP192_ADC_RATE) >> 6);
+
+    // One count = 0.5 mA for one ADC sample period, scaled by 65536
+    mah = 65536.0f * 0.5f * ((int64_t)discharge - (int64_t)charge) / 3600.0f / rateHz;
+    return true;
+}
+
+// Accumulate energy as charge x voltage over each sample interval
+static void sampleCoulombCounter() {
+    float mah;
+    if (!readCoulombMah(mah)) {
+        coulombValid = false;
+        return;
+    }
+
+    float batteryV = M5.Power.getBatteryVoltage() / 1000.0f;
+    if (coulombValid) {
+        float delta = mah - lastCoulombMah;
+        batteryMah += delta;
+        energyJ += delta * 3.6f * batteryV;  // mAh x V = 3.6 J
+    }
+
+    lastCoulombMah = mah;
+    coulombValid = true;
+}
+
+static void setDisplayPower(bool on) {
+    if (on == displayOn) {
+        return;
+    }
+
+    if (on) {
+        M5.Display.setBrightness(displayBrightness);
+        displaySetPower(true);
+    } else {
+        // Stop the display task first, then cut the backlight rail
+        displaySetPower(false);
+        displayBrightness = M5.Display.getBrightness();
+        M5.Power.Axp192.setDCDC3(0);
+    }
+
+    displayOn = on;
+    Serial.printf("Display %s\n", on ? "on" : "off");
+}
+
+static void applyModemSleep() {
+    bool connected = wifiIsConnected();
+    bool wantSleep = dutyCycled && !uploadAwake;
+
+    // Reconnects reset the power save mode, so re-apply on every transition
+    if (connected && (!wifiWasConnected || wantSleep != modemSleepApplied)) {
+        esp_wifi_set_ps(wantSleep ? WIFI_PS_MAX_MODEM : WIFI_PS_NONE);
+        modemSleepApplied = wantSleep;
+    }
+    wifiWasConnected = connected;
+}
+
+// Diagnostics "power" section: battery energy, for comparing profiles
+static void writeDiagSection(JsonVariant section) {
+    PowerStats power;
+    powerGetStats(power);
+    JsonObject pwr = section.to<JsonObject>();
+    pwr["profile"] = power.profile == POWER_PROFILE_DUTY_CYCLE ? "duty_cycle" : "continuous";
+    pwr["light_sleep"] = power.light_sleep;
+    pwr["sleep_pct"] = serialized(String(power.sleep_pct, 1));
+    pwr["display_on"] = power.display_on;
+    if (power.valid) {
+        pwr["battery_mah"] = serialized(String(power.battery_mah, 2));
+        pwr["energy_j"] = serialized(String(power.energy_j, 1));
+        pwr["avg_ma"] = serialized(String(power.avg_ma, 1));
+        pwr["mj_per_window"] = serialized(String(power.mj_per_window, 1));
+    }
+    pwr["windows_published"] = power.windows_published;
+}
+
+void powerInit() {
+    diagRegisterSection("power", writeDiagSection);
+
+    dutyCycled = POWER_PROFILE == POWER_PROFILE_DUTY_CYCLE;
+    lastActivityTime = millis();
+
+    // Count from zero so profiles can be compared run against run
+    M5.Power.Axp192.writeRegister8(AXP192_COULOMB_CTRL, AXP192_COULOMB_ENABLE | AXP192_COULOMB_CLEAR);
+    M5.Power.Axp192.writeRegister8(AXP192_COULOMB_CTRL, AXP192_COULOMB_ENABLE);
+    sampleCoulombCounter();
+    lastSampleTime = countStartTime = radioOnSince = millis();
+
+    if (!dutyCycled) {
+        Serial.println("Power profile: continuous");
+        return;
+    }
+
+#if POWER_HAS_PM
+    esp_pm_config_esp32_t pm = {};
+    pm.max_freq_mhz = 240;
+    pm.min_freq_mhz = 80;
+#if POWER_HAS_LIGHT_SLEEP
+    pm.light_sleep_enable = true;
+#endif
+    if (esp_pm_configure(&pm) == ESP_OK) {
+        autoLightSleep = POWER_HAS_LIGHT_SLEEP;
+    } else {
+        Serial.println("WARNING: esp_pm_configure failed");
+    }
+#endif
+
+    if (!autoLightSleep) {
+        // Touch controller interrupt wakes the CPU to turn the display on
+        gpio_wakeup_enable((gpio_num_t)POWER_TOUCH_WAKE_GPIO, GPIO_INTR_LOW_LEVEL);
+        esp_sleep_enable_gpio_wakeup();
+    }
+
+    // Sample one window per burst from the IMU FIFO instead of polling
+    imuSetBurstInterval(POWER_BURST_INTERVAL_MS);
+
+    applyModemSleep();
+
+    Serial.printf("Power profile: duty cycle (window every %d s, upload every %d s, light sleep %s)\n",
+                  POWER_BURST_INTERVAL_MS / 1000, POWER_UPLOAD_INTERVAL_MS / 1000,
+                  autoLightSleep ? "automatic" : "explicit between bursts");
+}
+
+bool powerIsDutyCycled() {
+    return dutyCycled;
+}
+
+void powerMaintain() {
+    unsigned long now = millis();
+
+    if (now - lastSampleTime >= POWER_SAMPLE_INTERVAL_MS) {
+        lastSampleTime = now;
+        sampleCoulombCounter();
+    }
+
+    if (!dutyCycled) {
+        return;
+    }
+
+    if (displayOn && now - lastActivityTime >= POWER_DISPLAY_TIMEOUT_MS) {
+        setDisplayPower(false);
+    }
+
+    if (uploadAwake && (long)(now - uploadAwakeUntil) >= 0) {
+        uploadAwake = false;
+    }
+    applyModemSleep();
+}
+
+bool powerNoteActivity() {
+    lastActivityTime = millis();
+
+    if (displayOn) {
+        return false;
+    }
+
+    setDisplayPower(true);
+    return true;
+}
+
+void powerBeginUpload() {
+    uploadAwake = true;
+    uploadAwakeUntil = millis() + POWER_UPLOAD_AWAKE_MS;
+    applyModemSleep();
+}
+
+void powerRecordPublished(uint32_t windows) {
+    windowsPublished += windows;
+}
+
+// Radio on for an upload window, off again once its publishes are acknowledged
+static void manageRadio(uint32_t untilUploadMs) {
+    unsigned long now = millis();
+
+    if (!radioOn) {
+        if (untilUploadMs <= POWER_RADIO_LEAD_MS) {
+            wifiResume();
+            radioOn = true;
+            radioOnSince = now;
+            Serial.println("Radio on for upload");
+        }
+        return;
+    }
+
+    if (uploadAwake || untilUploadMs <= POWER_RADIO_LEAD_MS) {
+        return;
+    }
+
+    // Unacknowledged publishes stay buffered for the next upload window
+    AwsPublishStats pub;
+    awsGetPublishStats(pub);
+    if (pub.in_flight > 0 && now - radioOnSince < POWER_RADIO_MAX_ON_MS) {
+        return;
+    }
+
+    awsDisconnect();
+    wifiSuspend();
+    radioOn = false;
+    Serial.printf("Radio off (%u publishes awaiting PUBACK)\n", pub.in_flight);
+}
+
+void powerIdle(uint32_t untilUploadMs) {
+    if (!dutyCycled) {
+        delay(10);
+        return;
+    }
+    if (autoLightSleep) {
+        // The idle task light-sleeps on its own during the delay
+        delay(POWER_LOOP_DELAY_MS);
+        return;
+    }
+
+    manageRadio(untilUploadMs);
+
+    // Awake while the display task, radio or an IMU burst needs the CPU
+    uint32_t nextBurstMs;
+    if (displayOn || radioOn || !imuGetNextBurst(nextBurstMs)) {
+        delay(POWER_LOOP_DELAY_MS);
+        return;
+    }
+
+    int32_t sleepMs = min((int32_t)POWER_SLEEP_MAX_MS, (int32_t)(untilUploadMs - POWER_RADIO_LEAD_MS));
+    sleepMs = min(sleepMs, (int32_t)(nextBurstMs - millis()) - POWER_SLEEP_MARGIN_MS);
+    if (sleepMs < POWER_SLEEP_MIN_MS) {
+        delay(POWER_LOOP_DELAY_MS);
+        return;
+    }
+
+    // Tasks stop until the timer or a touch; millis() keeps counting
+    Serial.flush();
+    esp_sleep_enable_timer_wakeup((uint64_t)sleepMs * 1000);
+    int64_t startUs = esp_timer_get_time();
+    esp_light_sleep_start();
+    sleptUs += esp_timer_get_time() - startUs;
+}
+
+void powerGetStats(PowerStats& stats) {
+    stats.profile = dutyCycled ? POWER_PROFILE_DUTY_CYCLE : POWER_PROFILE_CONTINUOUS;
+    stats.light_sleep = dutyCycled;
+    stats.sleep_pct = esp_timer_get_time() > 0 ? 100.0f * sleptUs / esp_timer_get_time() : 0;
+    stats.display_on = displayOn;
+    stats.battery_mah = batteryMah;
+    stats.energy_j = energyJ;
+    unsigned long elapsed = millis() - countStartTime;
+    stats.avg_ma = elapsed > 0 ? batteryMah / (elapsed / 3600000.0f) : 0;
+    stats.windows_published = windowsPublished;
+    stats.mj_per_window = windowsPublished > 0 ? energyJ * 1000.0f / windowsPublished : 0;
+    stats.valid = coulombValid;
+}
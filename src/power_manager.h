@@ -0,0 +1,49 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+
+// Battery energy accounting from the AXP192 coulomb counter
+struct PowerStats {
+    uint8_t profile;             // POWER_PROFILE_CONTINUOUS or POWER_PROFILE_DUTY_CYCLE
+    bool light_sleep;            // CPU light-sleeps between bursts (automatic or explicit)
+    float sleep_pct;             // Share of time since boot spent in explicit light sleep
+    bool display_on;             // Panel and backlight powered
+    float battery_mah;           // Net charge drawn from the battery since boot
+    float energy_j;              // Energy drawn from the battery since boot
+    float avg_ma;                // Mean battery current since boot
+    uint32_t windows_published;  // Telemetry windows published since boot
+    float mj_per_window;         // Energy per published window
+    bool valid;                  // false if the coulomb counter could not be read
+};
+
+// Apply the configured power profile (call from setup() after WiFi is up)
+void powerInit();
+
+// True when running the duty-cycled profile
+bool powerIsDutyCycled();
+
+// Display timeout, modem sleep and coulomb counter sampling
+// Call this from the main loop
+void powerMaintain();
+
+// Note user activity (touch)
+// Returns true if it woke the display, so the touch should be ignored
+bool powerNoteActivity();
+
+// Take the radio out of modem sleep for POWER_UPLOAD_AWAKE_MS
+void powerBeginUpload();
+
+// Count telemetry windows published, for energy per window
+void powerRecordPublished(uint32_t windows);
+
+// End of loop(): idle until there is work again
+// Duty cycle without automatic light sleep: switches the radio off between
+// uploads and light-sleeps until the next IMU burst, upload (untilUploadMs
+// from now, less POWER_RADIO_LEAD_MS for reconnecting) or touch
+void powerIdle(uint32_t untilUploadMs);
+
+// Get energy accounting since boot
+void powerGetStats(PowerStats& stats);
+
+#endif // POWER_MANAGER_H
@@ -0,0 +1,138 @@
+#ifndef SLIDING_STATS_H
+#define SLIDING_STATS_H
+
+// Portable (no Arduino dependencies) so the host-side tools can share it
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Statistics of the last n values of one signal (n <= N, set by reset),
+// updated in O(1) amortized per value: running sums for mean/RMS,
+// monotonic deques for max and min. The value ring doubles as the
+// outgoing-value source for the sums. Sums are recomputed from the ring
+// once per n values so rounding error cannot build up over hours.
+//
+// Nothing here wraps in a device's lifetime: the value count is 64-bit,
+// the ring slot wraps modulo n, and deque entries hold the low 32 bits of
+// their index, compared by age (wrap-safe since n < 2^31).
+template <size_t N>
+struct SlidingStats {
+    float values[N];
+    uint32_t n;              // Window length
+    uint32_t head;           // Ring slot of the next value (count % n)
+    uint64_t count;          // Values pushed since reset
+    double sum;
+    double sumSq;
+
+    // Deques of (index, value), ring-allocated; max is strictly decreasing
+    // from front to back, min strictly increasing
+    uint32_t maxIdx[N];
+    float maxVal[N];
+    uint16_t maxHead, maxLen;
+    uint32_t minIdx[N];
+    float minVal[N];
+    uint16_t minHead, minLen;
+
+    void reset(uint32_t window = N) {
+        n = window > 0 && window < N ? window : N;
+        head = 0;
+        count = 0;
+        sum = 0.0;
+        sumSq = 0.0;
+        maxHead = maxLen = 0;
+        minHead = minLen = 0;
+    }
+
+    void push(float v) {
+        if (count >= n) {
+            float old = values[head];
+            sum -= old;
+            sumSq -= (double)old * old;
+        }
+        values[head] = v;
+        sum += v;
+        sumSq += (double)v * v;
+
+        // Expire the value that just left the window (age n), then drop
+        // dominated tails
+        uint32_t idx = (uint32_t)count;
+        if (maxLen > 0 && idx - maxIdx[maxHead] >= n) { maxHead = (maxHead + 1) % N; maxLen--; }
+        if (minLen > 0 && idx - minIdx[minHead] >= n) { minHead = (minHead + 1) % N; minLen--; }
+        while (maxLen > 0 && maxVal[(maxHead + maxLen - 1) % N] <= v) maxLen--;
+        while (minLen > 0 && minVal[(minHead + minLen - 1) % N] >= v) minLen--;
+        size_t back = (maxHead + maxLen++) % N;
+        maxIdx[back] = idx;
+        maxVal[back] = v;
+        back = (minHead + minLen++) % N;
+        minIdx[back] = idx;
+        minVal[back] = v;
+
+        count++;
+
+        if (++head == n) {
+            head = 0;
+            resum();
+        }
+    }
+
+    uint32_t size() const {
+        return count < n ? (uint32_t)count : n;
+    }
+
+    bool full() const {
+        return count >= n;
+    }
+
+    float max() const {
+        return maxLen > 0 ? maxVal[maxHead] : 0.0f;
+    }
+
+    float min() const {
+        return minLen > 0 ? minVal[minHead] : 0.0f;
+    }
+
+    float mean() const {
+        uint32_t k = size();
+        return k > 0 ? (float)(sum / k) : 0.0f;
+    }
+
+    // RMS of the values themselves
+    float rms() const {
+        uint32_t k = size();
+        return k > 0 && sumSq > 0.0 ? (float)sqrt(sumSq / k) : 0.0f;
+    }
+
+    // RMS and peak about the window mean (as AxisStats)
+    float acRms() const {
+        uint32_t k = size();
+        if (k == 0) {
+            return 0.0f;
+        }
+        double m = sum / k;
+        double var = sumSq / k - m * m;
+        return var > 0.0 ? (float)sqrt(var) : 0.0f;
+    }
+
+    float acPeak() const {
+        float m = mean();
+        return fmaxf(max() - m, m - min());
+    }
+
+    // i-th value of the window, oldest first
+    float at(size_t i) const {
+        return values[(head + n - size() + i) % n];
+    }
+
+private:
+    void resum() {
+        sum = 0.0;
+        sumSq = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            sum += values[i];
+            sumSq += (double)values[i] * values[i];
+        }
+    }
+};
+
+#endif // SLIDING_STATS_H
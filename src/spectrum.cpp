@@ -0,0 +1,110 @@
+#include "spectrum.h"
+#include <math.h>
+#include <string.h>
+
+// FFT scratch (static: the IMU task stack is small) and twiddle table
+static float re[SPECTRUM_FFT_SIZE];
+static float im[SPECTRUM_FFT_SIZE];
+static float twiddleCos[SPECTRUM_FFT_SIZE / 2];
+static float twiddleSin[SPECTRUM_FFT_SIZE / 2];
+static bool twiddleReady = false;
+
+static void initTwiddles() {
+    for (int k = 0; k < SPECTRUM_FFT_SIZE / 2; k++) {
+        float a = -2.0f * (float)M_PI * k / SPECTRUM_FFT_SIZE;
+        twiddleCos[k] = cosf(a);
+        twiddleSin[k] = sinf(a);
+    }
+    twiddleReady = true;
+}
+
+// In-place iterative radix-2 FFT of re/im
+static void fft() {
+    const int n = SPECTRUM_FFT_SIZE;
+
+    // Bit-reversal permutation
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len >> 1;
+        int step = n / len;
+        for (int i = 0; i < n; i += len) {
+            for (int k = 0; k < half; k++) {
+                float wr = twiddleCos[k * step];
+                float wi = twiddleSin[k * step];
+                int a = i + k;
+                int b = a + half;
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] += tr;
+                im[a] += ti;
+            }
+        }
+    }
+}
+
+void spectrumCompute(const float samples[][3], size_t ringSize, size_t start,
+                     float sampleRateHz, VibrationSpectrum& out) {
+    if (!twiddleReady) {
+        initTwiddles();
+    }
+
+    size_t count = ringSize < SPECTRUM_FFT_SIZE ? ringSize : SPECTRUM_FFT_SIZE;
+
+    // Magnitude with the mean (1 g of gravity) removed
+    float mean = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        const float* s = samples[(start + i) % ringSize];
+        re[i] = sqrtf(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+        mean += re[i];
+    }
+    mean = count > 0 ? mean / count : 0.0f;
+
+    // Hann window over the real samples; zero-pad the rest
+    float windowSum = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        float w = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / (count > 1 ? count - 1 : 1));
+        re[i] = (re[i] - mean) * w;
+        im[i] = 0.0f;
+        windowSum += w;
+    }
+    memset(re + count, 0, (SPECTRUM_FFT_SIZE - count) * sizeof(float));
+    memset(im + count, 0, (SPECTRUM_FFT_SIZE - count) * sizeof(float));
+
+    fft();
+
+    // Single-sided amplitude, corrected for the window's coherent gain;
+    // bins 1 .. N/2-1 are split evenly across the bands (DC skipped)
+    const int bins = SPECTRUM_FFT_SIZE / 2;
+    const int binsPerBand = bins / SPECTRUM_BANDS;
+    const float scale = windowSum > 0 ? 2.0f / windowSum : 0.0f;
+
+    for (int b = 0; b < SPECTRUM_BANDS; b++) {
+        float peak = 0.0f;
+        for (int k = b * binsPerBand; k < (b + 1) * binsPerBand; k++) {
+            if (k == 0) {
+                continue;
+            }
+            float amp = sqrtf(re[k] * re[k] + im[k] * im[k]) * scale;
+            if (amp > peak) {
+                peak = amp;
+            }
+        }
+        out.bands_g[b] = peak;
+    }
+
+    out.band_hz = sampleRateHz / SPECTRUM_FFT_SIZE * binsPerBand;
+    out.valid = count > 0;
+}
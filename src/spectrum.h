@@ -0,0 +1,28 @@
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+// Portable (no Arduino dependencies) so the host-side tools can share it
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// FFT length; windows are zero-padded (or truncated) to this size
+#define SPECTRUM_FFT_SIZE  512
+
+// Amplitude spectrum of one window, reduced to display bands
+struct VibrationSpectrum {
+    float bands_g[SPECTRUM_BANDS];  // Peak amplitude per band (g)
+    float band_hz;                  // Width of one band
+    uint32_t seq;                   // Window sequence number (see imuGetHistory)
+    bool valid;
+};
+
+// Compute the amplitude spectrum of the acceleration magnitude
+// samples is a ring of count {x, y, z} entries in g, oldest at start
+// (0 for a plain array); the mean (gravity) is removed and a Hann
+// window applied. Not reentrant: uses static FFT buffers.
+void spectrumCompute(const float samples[][3], size_t count, size_t start,
+                     float sampleRateHz, VibrationSpectrum& out);
+
+#endif // SPECTRUM_H
@@ -1,54 +1,63 @@
 #include "telemetry.h"
 #include "config.h"
 #include "aws_iot.h"
+#include "diagnostics.h"
+#include "power_manager.h"
+#include "telemetry_format.h"
 #include <M5Unified.h>
 #include <WiFi.h>
-#include <ArduinoJson.h>
+#include <esp_timer.h>
 
-String telemetryBuildPayload(const VibrationMetrics& vib, const char* deviceId) {
-    JsonDocument doc;
+// Newest window included in a batched upload, per sensor
+static uint32_t lastUploadedSeq[IMU_MAX_SENSORS] = {};
 
-    // Device identification
-    doc["device_id"] = deviceId;
-    doc["timestamp"] = awsGetTime();
+// Last batched upload stopped with windows left (in-flight window full)
+static bool batchPending = false;
 
-    // Vibration metrics
-    JsonObject vibObj = doc["vibration"].to<JsonObject>();
-    vibObj["rms_g"] = serialized(String(vib.rms_g, 4));
-    vibObj["peak_g"] = serialized(String(vib.peak_g, 4));
+// Batched uploads: delta/varint blocks fit several times more windows per payload
+#if TELEMETRY_BLOCK_ENCODING
+#define BATCH_WINDOWS TELEMETRY_BLOCK_MAX
+#else
+#define BATCH_WINDOWS TELEMETRY_BATCH_MAX
+#endif
 
-    // Device health metrics
-    JsonObject health = doc["health"].to<JsonObject>();
+// Static: only the main loop uploads, and a block's worth is too big for its stack
+static VibrationMetrics batchWindows[BATCH_WINDOWS];
+
+// Formatted payload, shared by every publish path (same reason)
+static char payload[MQTT_INFLIGHT_PAYLOAD_MAX];
+static TelemetrySensorWindow others[IMU_MAX_SENSORS];
+
+static TelemetryHealth gatherHealth() {
+    TelemetryHealth health;
 
     // Battery voltage (mV to V)
-    int32_t batteryMv = M5.Power.getBatteryVoltage();
-    health["battery_v"] = serialized(String(batteryMv / 1000.0f, 2));
+    health.battery_v = M5.Power.getBatteryVoltage() / 1000.0f;
 
     // Internal temperature from AXP192
-    health["temp_c"] = serialized(String(M5.Power.Axp192.getInternalTemperature(), 1));
+    health.temp_c = M5.Power.Axp192.getInternalTemperature();
 
     // WiFi signal strength
-    health["rssi_dbm"] = WiFi.RSSI();
+    health.rssi_dbm = WiFi.RSSI();
 
     // System uptime in seconds
-    health["uptime_sec"] = millis() / 1000;
+    health.uptime_sec = millis() / 1000;
 
     // Free heap memory
-    health["free_heap"] = ESP.getFreeHeap();
-
-    // IMU temperature if available
-    if (vib.temp_c != 0) {
-        health["imu_temp_c"] = serialized(String(vib.temp_c, 1));
-    }
+    health.free_heap = ESP.getFreeHeap();
 
-    // Serialize to string
-    String payload;
-    serializeJson(doc, payload);
-    return payload;
+    return health;
 }
 
-String telemetryGetTopic(const char* deviceId) {
-    return String(MQTT_TOPIC_PREFIX) + deviceId + "/telemetry";
+static size_t formatBatch(char* buf, size_t size,
+                          const VibrationMetrics* windows, size_t count,
+                          const TelemetryHealth& health, const char* deviceId,
+                          const char* sensor) {
+#if TELEMETRY_BLOCK_ENCODING
+    return telemetryFormatBlockPayload(buf, size, windows, count, health, deviceId, sensor);
+#else
+    return telemetryFormatBatchPayload(buf, size, windows, count, health, deviceId, sensor);
+#endif
 }
 
 bool telemetryPublish() {
@@ -59,9 +68,122 @@ bool telemetryPublish() {
         return false;
     }
 
-    String deviceId = awsGetDeviceId();
-    String topic = telemetryGetTopic(deviceId.c_str());
-    String payload = telemetryBuildPayload(metrics, deviceId.c_str());
+    int64_t serializeStartUs = esp_timer_get_time();
+    diagRecordLatency(LAT_WINDOW_TO_SERIALIZE, serializeStartUs - metrics.window_us);
+
+    // Sensors beyond the internal IMU ride along with their latest window;
+    // single-sensor devices keep the original payload shape
+    uint8_t sensorCount = imuGetSensorCount();
+    size_t otherCount = 0;
+    for (uint8_t i = 1; i < sensorCount; i++) {
+        if (imuGetLatestMetrics(others[otherCount].metrics, i)) {
+            others[otherCount].name = imuGetSensorName(i);
+            otherCount++;
+        }
+    }
+    const char* sensor = sensorCount > 1 ? imuGetSensorName(0) : nullptr;
+
+    // Formatted in place: no String copies on the publish path
+    TelemetryHealth health = gatherHealth();
+    if (telemetryFormatPayload(payload, sizeof(payload), metrics, health, awsGetDeviceId(), awsGetTime(),
+                               sensor, others, otherCount) == 0) {
+        Serial.println("ERROR: Telemetry payload exceeds buffer");
+        return false;
+    }
+
+    int64_t publishStartUs = esp_timer_get_time();
+    diagRecordLatency(LAT_SERIALIZE, publishStartUs - serializeStartUs);
+
+    AwsPublishResult result = awsPublish(awsGetTopic(AWS_TOPIC_TELEMETRY), payload, MQTT_TELEMETRY_QOS, metrics.window_us);
+    bool published = result == AWS_PUBLISH_SENT || result == AWS_PUBLISH_QUEUED;
+
+    int64_t publishEndUs = esp_timer_get_time();
+    diagRecordLatency(LAT_PUBLISH, publishEndUs - publishStartUs);
+
+    // QoS 0: a successful local write is the only acknowledgement we get
+    // (QoS 1 acks are recorded by aws_iot when the PUBACK arrives)
+    if (published && MQTT_TELEMETRY_QOS == 0) {
+        diagRecordLatency(LAT_WINDOW_TO_ACK, publishEndUs - metrics.window_us);
+    }
+
+    if (published) {
+        powerRecordPublished(1);
+    }
+
+    return published;
+}
+
+// Uploads one sensor's unsent history; returns windows published
+static uint32_t publishSensorBatch(uint8_t sensor, const char* sensorName) {
+    VibrationMetrics* windows = batchWindows;
+    uint32_t publishedWindows = 0;
+
+    const char* deviceId = awsGetDeviceId();
+    const char* topic = awsGetTopic(AWS_TOPIC_TELEMETRY);
+    TelemetryHealth health = gatherHealth();
+
+    while (true) {
+        size_t n = imuGetHistory(lastUploadedSeq[sensor], windows, BATCH_WINDOWS, sensor);
+        if (n == 0) {
+            break;
+        }
+
+        // A backlog spans many payloads: with the in-flight window full,
+        // stop here and let the main loop resume once PUBACKs free a slot
+        if (!awsCanPublish(MQTT_TELEMETRY_QOS)) {
+            batchPending = true;
+            break;
+        }
+
+        // Drop windows from the end until the payload fits
+        int64_t serializeStartUs = esp_timer_get_time();
+        size_t count = n;
+        while (count > 0 && formatBatch(payload, sizeof(payload), windows, count,
+                                        health, deviceId, sensorName) == 0) {
+            count--;
+        }
+        if (count == 0) {
+            Serial.println("ERROR: Telemetry window exceeds buffer");
+            break;
+        }
+
+        int64_t publishStartUs = esp_timer_get_time();
+        diagRecordLatency(LAT_SERIALIZE, publishStartUs - serializeStartUs);
+
+        // Latency is tracked from the newest window in the payload
+        const VibrationMetrics& newest = windows[count - 1];
+        AwsPublishResult result = awsPublish(topic, payload, MQTT_TELEMETRY_QOS, newest.window_us);
+        if (result != AWS_PUBLISH_SENT && result != AWS_PUBLISH_QUEUED) {
+            break;
+        }
+        diagRecordLatency(LAT_PUBLISH, esp_timer_get_time() - publishStartUs);
+
+        // Queued counts as uploaded: the in-flight window owns the payload
+        // and resends it, so formatting these windows again would duplicate them
+        lastUploadedSeq[sensor] = newest.seq;
+        publishedWindows += count;
+        if (result == AWS_PUBLISH_QUEUED) {
+            break;
+        }
+    }
+
+    return publishedWindows;
+}
+
+uint32_t telemetryPublishBatch() {
+    uint32_t publishedWindows = 0;
+    batchPending = false;
+
+    // One payload stream per sensor, each with its own upload cursor
+    uint8_t sensorCount = imuGetSensorCount();
+    for (uint8_t sensor = 0; sensor < sensorCount; sensor++) {
+        publishedWindows += publishSensorBatch(sensor, sensorCount > 1 ? imuGetSensorName(sensor) : nullptr);
+    }
+
+    powerRecordPublished(publishedWindows);
+    return publishedWindows;
+}
 
-    return awsPublish(topic.c_str(), payload.c_str());
+bool telemetryBatchPending() {
+    return batchPending;
 }
@@ -4,15 +4,19 @@
 #include <Arduino.h>
 #include "imu_sampler.h"
 
-// Build JSON telemetry payload from vibration metrics
-// Includes device health data (battery, temperature, RSSI, uptime)
-String telemetryBuildPayload(const VibrationMetrics& vib, const char* deviceId);
-
 // Publish telemetry to AWS IoT
 // Returns true if published successfully
 bool telemetryPublish();
 
-// Get the topic string for telemetry
-String telemetryGetTopic(const char* deviceId);
+// Publish every window not yet uploaded, as batched payloads
+// (as many windows per payload as fit the in-flight buffer; delta/varint
+// blocks when TELEMETRY_BLOCK_ENCODING is set, else a JSON windows array)
+// Stops early, without error, when the in-flight window is full
+// Returns the number of windows published
+uint32_t telemetryPublishBatch();
+
+// True if the last telemetryPublishBatch() stopped at a full in-flight
+// window; call it again after awsMaintain() to continue
+bool telemetryBatchPending();
 
 #endif // TELEMETRY_H
@@ -0,0 +1,173 @@
+#include "telemetry_block.h"
+#include <math.h>
+
+// Fixed-point scale per column, matching the JSON payload's precision
+struct BlockColumnSpec {
+    TelemetryBlockColumn id;
+    uint8_t decimals;
+};
+
+static const BlockColumnSpec BLOCK_COLUMNS[BLOCK_COL_COUNT] = {
+    {BLOCK_COL_TIME_MS, 0},
+    {BLOCK_COL_RMS_G, 4},
+    {BLOCK_COL_PEAK_G, 4},
+    {BLOCK_COL_GX_RMS, 2},
+    {BLOCK_COL_GY_RMS, 2},
+    {BLOCK_COL_GZ_RMS, 2},
+    {BLOCK_COL_GX_PEAK, 2},
+    {BLOCK_COL_GY_PEAK, 2},
+    {BLOCK_COL_GZ_PEAK, 2},
+    {BLOCK_COL_IMU_TEMP_C, 1},
+    {BLOCK_COL_START_US, 0},
+    {BLOCK_COL_SAMPLES, 0},
+    {BLOCK_COL_FAULT, 0},
+    {BLOCK_COL_FAULT_CONF, 2},
+};
+
+static const float POW10[] = {1.0f, 10.0f, 100.0f, 1000.0f, 10000.0f};
+
+// Bounded byte writer: tracks overflow like PayloadWriter in telemetry_format.cpp
+struct BlockWriter {
+    uint8_t* buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+
+    void byte(uint8_t b) {
+        if (len >= size) {
+            overflow = true;
+            return;
+        }
+        buf[len++] = b;
+    }
+
+    void varint(uint64_t v) {
+        while (v >= 0x80) {
+            byte((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        byte((uint8_t)v);
+    }
+
+    // Small magnitudes of either sign map to small unsigned values
+    void zigzag(int64_t v) {
+        varint(((uint64_t)v << 1) ^ (uint64_t)(v >> 63));
+    }
+
+    static size_t varintSize(uint64_t v) {
+        size_t n = 1;
+        while (v >= 0x80) {
+            v >>= 7;
+            n++;
+        }
+        return n;
+    }
+};
+
+static float columnValue(const VibrationMetrics& vib, TelemetryBlockColumn id) {
+    switch (id) {
+        case BLOCK_COL_RMS_G:      return vib.rms_g;
+        case BLOCK_COL_PEAK_G:     return vib.peak_g;
+        case BLOCK_COL_GX_RMS:     return vib.gyro_rms_dps[0];
+        case BLOCK_COL_GY_RMS:     return vib.gyro_rms_dps[1];
+        case BLOCK_COL_GZ_RMS:     return vib.gyro_rms_dps[2];
+        case BLOCK_COL_GX_PEAK:    return vib.gyro_peak_dps[0];
+        case BLOCK_COL_GY_PEAK:    return vib.gyro_peak_dps[1];
+        case BLOCK_COL_GZ_PEAK:    return vib.gyro_peak_dps[2];
+        case BLOCK_COL_IMU_TEMP_C: return vib.temp_c;
+        default:                   return 0.0f;
+    }
+}
+
+static int64_t columnFixed(const VibrationMetrics& vib, const BlockColumnSpec& col) {
+    switch (col.id) {
+        case BLOCK_COL_TIME_MS:  return (int64_t)vib.epoch_ms;
+        case BLOCK_COL_START_US: return (int64_t)vib.start_epoch_us;
+        case BLOCK_COL_SAMPLES:  return vib.sample_count;
+        case BLOCK_COL_FAULT:    return vib.fault_class;
+        case BLOCK_COL_FAULT_CONF: return vib.fault_confidence;   // Percent = fraction at 2 decimals
+        default:                 break;
+    }
+    return (int64_t)lroundf(columnValue(vib, col.id) * POW10[col.decimals]);
+}
+
+// Zigzag varint deltas of one column; with dryRun only the length is computed
+static size_t writeColumnData(BlockWriter* w, const BlockColumnSpec& col,
+                              const VibrationMetrics* windows, size_t count) {
+    bool deltaOfDelta = col.id == BLOCK_COL_TIME_MS || col.id == BLOCK_COL_START_US;
+    int64_t prev = 0;
+    int64_t prevDelta = 0;
+    size_t bytes = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (windows[i].epoch_ms == 0) {
+            continue;
+        }
+
+        int64_t value = columnFixed(windows[i], col);
+        int64_t delta = value - prev;
+        int64_t encoded = deltaOfDelta ? delta - prevDelta : delta;
+        prev = value;
+        prevDelta = delta;
+
+        if (w != nullptr) {
+            w->zigzag(encoded);
+        } else {
+            bytes += BlockWriter::varintSize(((uint64_t)encoded << 1) ^ (uint64_t)(encoded >> 63));
+        }
+    }
+    return bytes;
+}
+
+size_t telemetryEncodeBlock(uint8_t* buf, size_t size,
+                            const VibrationMetrics* windows, size_t count) {
+    size_t stamped = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (windows[i].epoch_ms != 0) {
+            stamped++;
+        }
+    }
+    if (stamped == 0) {
+        return 0;
+    }
+
+    BlockWriter w = {buf, size, 0, false};
+    w.byte('V');
+    w.byte('B');
+    w.byte(TELEMETRY_BLOCK_VERSION);
+    w.byte(BLOCK_COL_COUNT);
+    w.varint(stamped);
+
+    for (const BlockColumnSpec& col : BLOCK_COLUMNS) {
+        w.byte(col.id);
+        w.byte(col.decimals);
+        w.varint(writeColumnData(nullptr, col, windows, count));
+        writeColumnData(&w, col, windows, count);
+    }
+
+    return w.overflow ? 0 : w.len;
+}
+
+size_t telemetryBase64(char* out, size_t size, const uint8_t* data, size_t len) {
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    size_t outLen = (len + 2) / 3 * 4;
+    if (outLen + 1 > size) {
+        return 0;
+    }
+
+    char* p = out;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len) v |= data[i + 2];
+
+        *p++ = ALPHABET[(v >> 18) & 0x3F];
+        *p++ = ALPHABET[(v >> 12) & 0x3F];
+        *p++ = i + 1 < len ? ALPHABET[(v >> 6) & 0x3F] : '=';
+        *p++ = i + 2 < len ? ALPHABET[v & 0x3F] : '=';
+    }
+    *p = '\0';
+
+    return outLen;
+}
@@ -0,0 +1,53 @@
+#ifndef TELEMETRY_BLOCK_H
+#define TELEMETRY_BLOCK_H
+
+// Portable (no Arduino dependencies) so the host-side tools can share it
+//
+// Columnar block of consecutive windows for batched uploads. Each column
+// is fixed point at the precision the JSON payload carries, stored as the
+// zigzag varint of its delta from the previous window (the time columns
+// as delta-of-delta, since windows close at a steady cadence). Correlated
+// windows then cost one or two bytes per value instead of a JSON field.
+//
+// Layout (decoder: aws/telemetry_block.py):
+//   'V' 'B' version column_count varint(window_count)
+//   per column: id decimals varint(byte_length) data[byte_length]
+// The byte length lets a decoder skip columns it does not know.
+
+#include <stddef.h>
+#include <stdint.h>
+#include "vibration_metrics.h"
+
+#define TELEMETRY_BLOCK_VERSION 1
+
+// Column ids are part of the wire format: append only, never renumber
+enum TelemetryBlockColumn : uint8_t {
+    BLOCK_COL_TIME_MS = 0,   // epoch_ms, delta-of-delta
+    BLOCK_COL_RMS_G,
+    BLOCK_COL_PEAK_G,
+    BLOCK_COL_GX_RMS,
+    BLOCK_COL_GY_RMS,
+    BLOCK_COL_GZ_RMS,
+    BLOCK_COL_GX_PEAK,
+    BLOCK_COL_GY_PEAK,
+    BLOCK_COL_GZ_PEAK,
+    BLOCK_COL_IMU_TEMP_C,    // 0 when the IMU reported no temperature
+    BLOCK_COL_START_US,      // start_epoch_us, delta-of-delta
+    BLOCK_COL_SAMPLES,       // sample_count
+    BLOCK_COL_FAULT,         // fault_class (FaultClass id)
+    BLOCK_COL_FAULT_CONF,    // fault_confidence as a fraction; 0 = not classified
+    BLOCK_COL_COUNT
+};
+
+// Encode windows into a block; windows without an epoch stamp are skipped
+// (as in the batched JSON payload). Each column is sized, then written,
+// straight from the windows, so no scratch memory is needed.
+// Returns the block length, or 0 if buf is too small or no window is stamped
+size_t telemetryEncodeBlock(uint8_t* buf, size_t size,
+                            const VibrationMetrics* windows, size_t count);
+
+// Base64 (RFC 4648, padded) into out, NUL terminated
+// Returns the encoded length, or 0 if out is too small
+size_t telemetryBase64(char* out, size_t size, const uint8_t* data, size_t len);
+
+#endif // TELEMETRY_BLOCK_H
@@ -0,0 +1,253 @@
+#include "telemetry_format.h"
+#include "config.h"
+#include "fault_classifier.h"
+#include "telemetry_block.h"
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// Bounded append helper: tracks overflow instead of truncating silently
+struct PayloadWriter {
+    char* buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+
+    void append(const char* fmt, ...) {
+        if (overflow) {
+            return;
+        }
+
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(buf + len, size - len, fmt, args);
+        va_end(args);
+
+        if (n < 0 || (size_t)n >= size - len) {
+            overflow = true;
+            return;
+        }
+        len += n;
+    }
+};
+
+// Window extent: UTC start of the first sample and sample count, so
+// windows from different devices can be joined exactly
+static void appendExtent(PayloadWriter& w, const VibrationMetrics& vib) {
+    if (vib.start_epoch_us != 0) {
+        w.append(",\"start_us\":%llu", (unsigned long long)vib.start_epoch_us);
+    }
+    w.append(",\"samples\":%u", (unsigned)vib.sample_count);
+}
+
+// Per-axis angular rate metrics (deg/s), flat so rules and Timestream can map them directly
+static void appendGyro(PayloadWriter& w, const VibrationMetrics& vib) {
+    w.append(",\"gx_rms\":%.2f,\"gy_rms\":%.2f,\"gz_rms\":%.2f,\"gx_peak\":%.2f,\"gy_peak\":%.2f,\"gz_peak\":%.2f",
+             vib.gyro_rms_dps[0], vib.gyro_rms_dps[1], vib.gyro_rms_dps[2],
+             vib.gyro_peak_dps[0], vib.gyro_peak_dps[1], vib.gyro_peak_dps[2]);
+}
+
+// On-device fault classification, once the window has one
+static void appendFault(PayloadWriter& w, const VibrationMetrics& vib) {
+    if (vib.fault_confidence != 0) {
+        w.append(",\"fault\":\"%s\",\"fault_conf\":%.2f",
+                 faultClassName(vib.fault_class), vib.fault_confidence / 100.0f);
+    }
+}
+
+// Names the sensor of a multi-sensor device's top-level window(s)
+static void appendSensor(PayloadWriter& w, const char* sensor) {
+    if (sensor != nullptr) {
+        w.append(",\"sensor\":\"%s\"", sensor);
+    }
+}
+
+size_t telemetryFormatPayload(char* buf, size_t size,
+                              const VibrationMetrics& vib,
+                              const TelemetryHealth& health,
+                              const char* deviceId,
+                              unsigned long fallbackTime,
+                              const char* sensor,
+                              const TelemetrySensorWindow* others,
+                              size_t otherCount) {
+    if (size == 0) {
+        return 0;
+    }
+
+    PayloadWriter w = {buf, size, 0, false};
+
+    // Device identification (serial number: hex digits, no escaping needed)
+    w.append("{\"device_id\":\"%s\"", deviceId);
+    appendSensor(w, sensor);
+
+    // Time the window was measured, not when it is published
+    if (vib.epoch_ms != 0) {
+        w.append(",\"timestamp\":%lu,\"timestamp_ms\":%llu",
+                 (unsigned long)(vib.epoch_ms / 1000), (unsigned long long)vib.epoch_ms);
+    } else {
+        w.append(",\"timestamp\":%lu", fallbackTime);
+    }
+
+    // Vibration metrics
+    w.append(",\"vibration\":{\"rms_g\":%.4f,\"peak_g\":%.4f", vib.rms_g, vib.peak_g);
+    appendExtent(w, vib);
+    appendGyro(w, vib);
+    appendFault(w, vib);
+    w.append("}");
+
+    // Other sensors' latest windows, each with its own close time
+    if (otherCount > 0) {
+        w.append(",\"sensors\":{");
+        for (size_t i = 0; i < otherCount; i++) {
+            const VibrationMetrics& other = others[i].metrics;
+            w.append("%s\"%s\":{\"rms_g\":%.4f,\"peak_g\":%.4f",
+                     i == 0 ? "" : ",", others[i].name, other.rms_g, other.peak_g);
+            if (other.epoch_ms != 0) {
+                w.append(",\"timestamp_ms\":%llu", (unsigned long long)other.epoch_ms);
+            }
+            appendExtent(w, other);
+            appendGyro(w, other);
+            appendFault(w, other);
+            if (other.temp_c != 0) {
+                w.append(",\"imu_temp_c\":%.1f", other.temp_c);
+            }
+            w.append("}");
+        }
+        w.append("}");
+    }
+
+    // Device health metrics
+    w.append(",\"health\":{\"battery_v\":%.2f,\"temp_c\":%.1f,\"rssi_dbm\":%ld,\"uptime_sec\":%lu,\"free_heap\":%lu",
+             health.battery_v, health.temp_c, (long)health.rssi_dbm,
+             (unsigned long)health.uptime_sec, (unsigned long)health.free_heap);
+
+    // IMU temperature if available
+    if (vib.temp_c != 0) {
+        w.append(",\"imu_temp_c\":%.1f", vib.temp_c);
+    }
+
+    w.append("}}");
+
+    return w.overflow ? 0 : w.len;
+}
+
+static void appendHealth(PayloadWriter& w, const TelemetryHealth& health) {
+    w.append(",\"health\":{\"battery_v\":%.2f,\"temp_c\":%.1f,\"rssi_dbm\":%ld,\"uptime_sec\":%lu,\"free_heap\":%lu}",
+             health.battery_v, health.temp_c, (long)health.rssi_dbm,
+             (unsigned long)health.uptime_sec, (unsigned long)health.free_heap);
+}
+
+size_t telemetryFormatBatchPayload(char* buf, size_t size,
+                                   const VibrationMetrics* windows, size_t count,
+                                   const TelemetryHealth& health,
+                                   const char* deviceId,
+                                   const char* sensor) {
+    if (size == 0) {
+        return 0;
+    }
+
+    PayloadWriter w = {buf, size, 0, false};
+
+    w.append("{\"device_id\":\"%s\"", deviceId);
+    appendSensor(w, sensor);
+    appendHealth(w, health);
+
+    // Only windows with an epoch stamp can be placed in time
+    w.append(",\"windows\":[");
+    bool first = true;
+    for (size_t i = 0; i < count; i++) {
+        const VibrationMetrics& vib = windows[i];
+        if (vib.epoch_ms == 0) {
+            continue;
+        }
+
+        w.append("%s{\"timestamp\":%lu,\"timestamp_ms\":%llu,\"rms_g\":%.4f,\"peak_g\":%.4f",
+                 first ? "" : ",",
+                 (unsigned long)(vib.epoch_ms / 1000), (unsigned long long)vib.epoch_ms,
+                 vib.rms_g, vib.peak_g);
+        appendExtent(w, vib);
+        appendGyro(w, vib);
+        appendFault(w, vib);
+        if (vib.temp_c != 0) {
+            w.append(",\"imu_temp_c\":%.1f", vib.temp_c);
+        }
+        w.append("}");
+        first = false;
+    }
+    w.append("]}");
+
+    return w.overflow ? 0 : w.len;
+}
+
+size_t telemetryFormatBlockPayload(char* buf, size_t size,
+                                   const VibrationMetrics* windows, size_t count,
+                                   const TelemetryHealth& health,
+                                   const char* deviceId,
+                                   const char* sensor) {
+    if (size == 0) {
+        return 0;
+    }
+
+    PayloadWriter w = {buf, size, 0, false};
+
+    w.append("{\"device_id\":\"%s\"", deviceId);
+    appendSensor(w, sensor);
+    appendHealth(w, health);
+    w.append(",\"encoding\":\"vb%d\",\"block\":\"", TELEMETRY_BLOCK_VERSION);
+    if (w.overflow) {
+        return 0;
+    }
+
+    // Encode into the tail of buf, then base64 it into place. Output
+    // position stays behind the read position as long as the tail start
+    // leaves a third of the block length of slack after the JSON prefix.
+    const size_t suffix = 3;  // "}" + "\"" + NUL
+    size_t room = size - w.len;
+    if (room <= suffix) {
+        return 0;
+    }
+    size_t maxBlock = (room - suffix) / 4 * 3;
+    uint8_t* tail = (uint8_t*)buf + size - maxBlock;
+    size_t blockLen = telemetryEncodeBlock(tail, maxBlock, windows, count);
+    if (blockLen == 0) {
+        return 0;
+    }
+
+    // Slide the block to the end so base64 output never overtakes it
+    memmove(buf + size - blockLen, tail, blockLen);
+    size_t encoded = telemetryBase64(buf + w.len, size - w.len, (const uint8_t*)buf + size - blockLen, blockLen);
+    if (encoded == 0) {
+        return 0;
+    }
+    w.len += encoded;
+
+    w.append("\"}");
+
+    return w.overflow ? 0 : w.len;
+}
+
+size_t telemetryFormatDeviceTopic(char* buf, size_t size, const char* deviceId, const char* leaf) {
+    int n = snprintf(buf, size, "%s%s/%s", MQTT_TOPIC_PREFIX, deviceId, leaf);
+    return (n < 0 || (size_t)n >= size) ? 0 : (size_t)n;
+}
+
+size_t telemetryFormatTopic(char* buf, size_t size, const char* deviceId) {
+    return telemetryFormatDeviceTopic(buf, size, deviceId, "telemetry");
+}
+
+size_t telemetryFormatIngestTopic(char* buf, size_t size, const char* rule,
+                                  const char* deviceId, const char* leaf) {
+    size_t ruleLen = strlen(rule);
+    if (ruleLen == 0 || ruleLen > MQTT_BASIC_INGEST_RULE_MAX) {
+        return 0;
+    }
+    for (size_t i = 0; i < ruleLen; i++) {
+        if (!isalnum((unsigned char)rule[i]) && rule[i] != '_') {
+            return 0;
+        }
+    }
+
+    int n = snprintf(buf, size, "%s%s/%s%s/%s", MQTT_BASIC_INGEST_PREFIX, rule, MQTT_TOPIC_PREFIX, deviceId, leaf);
+    return (n < 0 || (size_t)n >= size) ? 0 : (size_t)n;
+}
@@ -0,0 +1,75 @@
+#ifndef TELEMETRY_FORMAT_H
+#define TELEMETRY_FORMAT_H
+
+// Portable (no Arduino dependencies) so the host-side tools can share it
+
+#include <stddef.h>
+#include <stdint.h>
+#include "vibration_metrics.h"
+
+// Device health values gathered at publish time
+struct TelemetryHealth {
+    float battery_v;      // LiPo voltage
+    float temp_c;         // AXP192 internal temperature
+    int32_t rssi_dbm;     // WiFi signal strength
+    uint32_t uptime_sec;  // Seconds since boot
+    uint32_t free_heap;   // Free heap in bytes
+};
+
+// Latest window of another sensor on the same device
+struct TelemetrySensorWindow {
+    const char* name;
+    VibrationMetrics metrics;
+};
+
+// Format the JSON telemetry payload into buf
+// fallbackTime (epoch seconds) is used when the window has no epoch stamp.
+// On multi-sensor devices, sensor names the sensor of "vibration" and
+// others become "sensors": {"<name>": {timestamp_ms, rms_g, ...}, ...}
+// Returns the payload length, or 0 if buf is too small
+size_t telemetryFormatPayload(char* buf, size_t size,
+                              const VibrationMetrics& vib,
+                              const TelemetryHealth& health,
+                              const char* deviceId,
+                              unsigned long fallbackTime,
+                              const char* sensor = nullptr,
+                              const TelemetrySensorWindow* others = nullptr,
+                              size_t otherCount = 0);
+
+// Format several windows into one batched JSON payload
+// {"device_id"[, "sensor"], "health", "windows": [{timestamp, timestamp_ms, rms_g, peak_g}, ...]}
+// Health is sampled once, at publish time, and belongs to the newest window
+// Returns the payload length, or 0 if buf is too small
+size_t telemetryFormatBatchPayload(char* buf, size_t size,
+                                   const VibrationMetrics* windows, size_t count,
+                                   const TelemetryHealth& health,
+                                   const char* deviceId,
+                                   const char* sensor = nullptr);
+
+// Format several windows as a delta/varint block (telemetry_block.h)
+// {"device_id"[, "sensor"], "health", "encoding": "vb1", "block": "<base64>"}
+// Same contents as the batched payload in a fraction of the bytes
+// Returns the payload length, or 0 if buf is too small
+size_t telemetryFormatBlockPayload(char* buf, size_t size,
+                                   const VibrationMetrics* windows, size_t count,
+                                   const TelemetryHealth& health,
+                                   const char* deviceId,
+                                   const char* sensor = nullptr);
+
+// Format a device topic (MQTT_TOPIC_PREFIX{deviceId}/{leaf}) into buf
+// Returns the topic length, or 0 if buf is too small
+size_t telemetryFormatDeviceTopic(char* buf, size_t size, const char* deviceId, const char* leaf);
+
+// Format the telemetry topic for a device into buf
+// Returns the topic length, or 0 if buf is too small
+size_t telemetryFormatTopic(char* buf, size_t size, const char* deviceId);
+
+// Format a Basic Ingest topic (MQTT_BASIC_INGEST_PREFIX{rule}/ followed by
+// the device topic) into buf. The rule sees the usual device topic, so
+// topic(n) in its SQL works on either path
+// Returns the topic length, or 0 if buf is too small or rule is not a
+// valid rule name (letters, digits, underscores)
+size_t telemetryFormatIngestTopic(char* buf, size_t size, const char* rule,
+                                  const char* deviceId, const char* leaf);
+
+#endif // TELEMETRY_FORMAT_H
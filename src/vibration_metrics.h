@@ -0,0 +1,30 @@
+#ifndef VIBRATION_METRICS_H
+#define VIBRATION_METRICS_H
+
+// Portable (no Arduino dependencies) so the host-side tools can share it
+
+#include <stdint.h>
+
+// Vibration metrics computed from IMU samples. The statistics cover the
+// sensor's last windowSamples samples; start_epoch_us and sample_count
+// cover only those between the window's UTC boundaries, so with missed
+// reads the statistics reach back further than start_epoch_us.
+struct VibrationMetrics {
+    float rms_g;       // Root mean square acceleration magnitude
+    float peak_g;      // Peak acceleration magnitude
+    float temp_c;      // IMU temperature (if available)
+    float gyro_rms_dps[3];   // Angular rate RMS per axis (x, y, z) about the window mean
+    float gyro_peak_dps[3];  // Largest angular rate deviation from the window mean per axis
+    uint32_t timestamp; // Timestamp when metrics were computed
+    uint64_t epoch_ms;  // UTC time the window closed (0 if clock not synced)
+    uint64_t start_epoch_us; // UTC time of the first sample within the window's boundaries (0 if clock not synced)
+    int64_t window_us;  // esp_timer time the window closed (for latency)
+    uint32_t seq;       // Window sequence number since boot (first window = 1)
+    uint16_t sample_count;   // Samples within the window's boundaries
+    uint8_t sensor;          // Sampler index (0 = internal IMU, see imuGetSensorName)
+    uint8_t fault_class;     // FaultClass of the latest classification (fault_classifier.h)
+    uint8_t fault_confidence; // Its confidence in percent (0 = not classified)
+    bool valid;        // True if metrics are valid
+};
+
+#endif // VIBRATION_METRICS_H
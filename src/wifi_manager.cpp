@@ -1,9 +1,11 @@
 #include "wifi_manager.h"
+#include "clock_sync.h"
 #include "config.h"
 #include "secrets.h"
 #include <M5Unified.h>
 
 static unsigned long lastReconnectAttempt = 0;
+static bool suspended = false;
 
 bool wifiConnect() {
     Serial.printf("Connecting to WiFi: %s\n", WIFI_SSID);
@@ -25,13 +27,14 @@ bool wifiConnect() {
     Serial.printf("WiFi connected! IP: %s\n", WiFi.localIP().toString().c_str());
     Serial.printf("RSSI: %d dBm\n", WiFi.RSSI());
 
-    // Configure NTP for certificate validation
+    // Configure NTP for certificate validation and window alignment
+    clockInit();
     configTime(0, 0, "pool.ntp.org", "time.nist.gov");
 
     // Wait for time to sync
     Serial.print("Waiting for NTP time sync");
     time_t now = time(nullptr);
-    while (now < 8 * 3600 * 2) {
+    while (now < CLOCK_MIN_VALID_EPOCH_S) {
         delay(500);
         Serial.print(".");
         now = time(nullptr);
@@ -54,7 +57,7 @@ int wifiGetRSSI() {
 }
 
 void wifiMaintain() {
-    if (WiFi.status() != WL_CONNECTED) {
+    if (!suspended && WiFi.status() != WL_CONNECTED) {
         unsigned long now = millis();
         if (now - lastReconnectAttempt > WIFI_RETRY_DELAY_MS) {
             lastReconnectAttempt = now;
@@ -64,3 +67,26 @@ void wifiMaintain() {
         }
     }
 }
+
+void wifiSuspend() {
+    if (suspended) {
+        return;
+    }
+    suspended = true;
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+}
+
+void wifiResume() {
+    if (!suspended) {
+        return;
+    }
+    suspended = false;
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    lastReconnectAttempt = millis();
+}
+
+bool wifiIsSuspended() {
+    return suspended;
+}
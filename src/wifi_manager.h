@@ -16,4 +16,13 @@ int wifiGetRSSI();
 // Reconnect if disconnected (call periodically from main loop)
 void wifiMaintain();
 
+// Turn the radio off, with no reconnect attempts until wifiResume()
+void wifiSuspend();
+
+// Turn the radio back on and start reconnecting
+void wifiResume();
+
+// True between wifiSuspend() and wifiResume()
+bool wifiIsSuspended();
+
 #endif // WIFI_MANAGER_H